@@ -0,0 +1,292 @@
+
+// ------------------------------------------------
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+// ------------------------------------------------
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// ------------------------------------------------
+
+#include "benchmark/benchmark.h"
+#include "basic_json.hpp"
+#include "Corpus.hpp"
+
+// ------------------------------------------------
+
+using namespace kaixo;
+using namespace kaixo::bench;
+
+// ------------------------------------------------
+
+namespace {
+
+    // ------------------------------------------------
+
+    std::atomic<std::size_t> allocations = 0;
+
+    // Peak resident set size of the process in bytes
+    std::size_t peak_rss() {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+        return static_cast<std::size_t>(usage.ru_maxrss); // bytes
+#else
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+    }
+
+    // ------------------------------------------------
+
+    // Counts allocations made while running the benchmark loop
+    struct allocation_counter {
+        benchmark::State& state;
+        std::size_t start = allocations.load(std::memory_order_relaxed);
+
+        ~allocation_counter() {
+            auto count = allocations.load(std::memory_order_relaxed) - start;
+            state.counters["allocs/doc"] = benchmark::Counter(static_cast<double>(count), benchmark::Counter::kAvgIterations);
+            state.counters["peak_rss_mb"] = static_cast<double>(peak_rss()) / (1024.0 * 1024.0);
+        }
+    };
+
+    // ------------------------------------------------
+
+    basic_json parse_or_abort(const document& doc) {
+        auto result = basic_json::parse(doc.text);
+        if (!result.has_value()) {
+            std::fprintf(stderr, "failed to parse corpus document '%s'\n", doc.name.c_str());
+            std::abort();
+        }
+        return std::move(result.value());
+    }
+
+    // Keys of the object for access benchmarks, empty when not an object
+    std::vector<std::string> keys_of(const basic_json& json) {
+        std::vector<std::string> result;
+        if (json.is<basic_json::object_t>())
+            for (auto& [key, _] : json.as<basic_json::object_t>()) result.push_back(key);
+        return result;
+    }
+
+    // ------------------------------------------------
+
+    void parse(benchmark::State& state, const document& doc) {
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            auto result = basic_json::parse(doc.text);
+            benchmark::DoNotOptimize(result);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * doc.text.size()));
+    }
+
+    // Numbers kept as text, a proxy that parses and serializes without converting them
+    void parse_lazy(benchmark::State& state, const document& doc) {
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            auto result = basic_json::parse(doc.text, { .lazy_numbers = true });
+            benchmark::DoNotOptimize(result);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * doc.text.size()));
+    }
+
+    // Steady state of a worker parsing same-shaped messages into one document
+    void parse_into(benchmark::State& state, const document& doc) {
+        basic_json json = parse_or_abort(doc);
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            auto result = basic_json::parse_into(json, doc.text);
+            benchmark::DoNotOptimize(result);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * doc.text.size()));
+    }
+
+    void to_string(benchmark::State& state, const document& doc) {
+        auto json = parse_or_abort(doc);
+        std::size_t bytes = json.to_string().size();
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            auto result = json.to_string();
+            benchmark::DoNotOptimize(result);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    }
+
+    void to_pretty_string(benchmark::State& state, const document& doc) {
+        auto json = parse_or_abort(doc);
+        std::size_t bytes = json.to_pretty_string().size();
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            auto result = json.to_pretty_string();
+            benchmark::DoNotOptimize(result);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * bytes));
+    }
+
+    void access(benchmark::State& state, const document& doc) {
+        auto json = parse_or_abort(doc);
+        auto keys = keys_of(json);
+        if (keys.empty()) return state.SkipWithError("document is not an object");
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            for (auto& key : keys) benchmark::DoNotOptimize(json[key]);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * keys.size()));
+    }
+
+    void merge(benchmark::State& state, const document& doc) {
+        auto json = parse_or_abort(doc);
+        if (!json.is<basic_json::object_t>()) return state.SkipWithError("document is not an object");
+        basic_json half;
+        std::size_t index = 0;
+        for (auto& [key, val] : json.as<basic_json::object_t>())
+            if (index++ % 2 == 0) half[key] = val;
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            basic_json target = half;
+            target.merge(json);
+            benchmark::DoNotOptimize(target);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * index));
+    }
+
+    // Cached document wrapped in a small envelope, spliced without parsing it
+    void raw_envelope(benchmark::State& state, const document& doc) {
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            basic_json envelope{ { "status", "ok" }, { "data", basic_json::raw_json{ doc.text } } };
+            auto result = envelope.to_string();
+            benchmark::DoNotOptimize(result);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * doc.text.size()));
+    }
+
+    // Columns of a root array of objects, straight from the text
+    void shred(benchmark::State& state, const document& doc) {
+        auto json = parse_or_abort(doc);
+        bool records = json.is<basic_json::array_t>() && !json.empty()
+            && std::ranges::all_of(json.as<basic_json::array_t>(), [](const basic_json& val) { return val.is<basic_json::object_t>(); });
+        if (!records) return state.SkipWithError("document is not an array of objects");
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            auto result = basic_json::table::shred(doc.text);
+            benchmark::DoNotOptimize(result);
+        }
+        state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * doc.text.size()));
+    }
+
+    // Every value in the document, a query visiting all nodes
+    void query(benchmark::State& state, const document& doc) {
+        auto json = parse_or_abort(doc);
+        basic_json::query everything{ "$..*" };
+        std::size_t matches = everything.select(json).size();
+        allocation_counter _counter{ state };
+        for (auto _ : state) {
+            auto result = everything.select(json);
+            benchmark::DoNotOptimize(result);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * matches));
+    }
+
+    // Readers on every thread load a snapshot and look up a key, while the first
+    // thread also publishes a new version every 1024 iterations.
+    void store_read(benchmark::State& state, const document& doc) {
+        static std::atomic<basic_json::store*> shared = nullptr;
+        basic_json json = parse_or_abort(doc);
+        auto keys = keys_of(json);
+        if (keys.empty()) return state.SkipWithError("document is not an object");
+        json.share(); // Publishing copies are O(1)
+
+        std::unique_ptr<basic_json::store> owned;
+        if (state.thread_index() == 0) {
+            owned = std::make_unique<basic_json::store>(json);
+            shared.store(owned.get());
+        }
+
+        basic_json::store* config = nullptr;
+        while (!(config = shared.load())) std::this_thread::yield();
+
+        std::size_t index = 0;
+        for (auto _ : state) {
+            auto snapshot = config->load();
+            benchmark::DoNotOptimize((*snapshot)[keys[index++ % keys.size()]]);
+            if (state.thread_index() == 0 && index % 1024 == 0) config->publish(json);
+        }
+
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+        if (state.thread_index() == 0) shared.store(nullptr); // All threads have left the loop
+    }
+
+    // ------------------------------------------------
+
+    void register_document(const document& doc) {
+        benchmark::RegisterBenchmark("parse/" + doc.name, parse, doc);
+        benchmark::RegisterBenchmark("parse_lazy/" + doc.name, parse_lazy, doc);
+        benchmark::RegisterBenchmark("parse_into/" + doc.name, parse_into, doc);
+        benchmark::RegisterBenchmark("to_string/" + doc.name, to_string, doc);
+        benchmark::RegisterBenchmark("to_pretty_string/" + doc.name, to_pretty_string, doc);
+        benchmark::RegisterBenchmark("access/" + doc.name, access, doc);
+        benchmark::RegisterBenchmark("merge/" + doc.name, merge, doc);
+        benchmark::RegisterBenchmark("query/" + doc.name, query, doc);
+        benchmark::RegisterBenchmark("shred/" + doc.name, shred, doc);
+        benchmark::RegisterBenchmark("raw_envelope/" + doc.name, raw_envelope, doc);
+        benchmark::RegisterBenchmark("store_read/" + doc.name, store_read, doc)
+            ->ThreadRange(1, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())))->UseRealTime();
+    }
+
+    // ------------------------------------------------
+
+}
+
+// ------------------------------------------------
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// ------------------------------------------------
+
+int main(int argc, char** argv) {
+
+    // ------------------------------------------------
+
+    // Documents must outlive the registered benchmarks
+    static std::vector<document> corpus = synthetic_corpus();
+    for (auto& doc : file_corpus(BASIC_JSON_BENCH_DATA)) corpus.push_back(std::move(doc));
+    for (auto& doc : corpus) register_document(doc);
+
+    // ------------------------------------------------
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+
+    // ------------------------------------------------
+
+}
+
+// ------------------------------------------------
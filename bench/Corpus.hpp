@@ -0,0 +1,151 @@
+#pragma once
+
+// ------------------------------------------------
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ------------------------------------------------
+
+namespace kaixo::bench {
+
+    // ------------------------------------------------
+
+    struct document {
+        std::string name;
+        std::string text;
+    };
+
+    // ------------------------------------------------
+
+    // All generators are seeded, so the corpus is identical between runs
+    inline std::mt19937_64 generator(std::size_t seed) { return std::mt19937_64{ 0x6b616978 + seed }; }
+
+    inline std::string random_word(std::mt19937_64& rng, std::size_t minLength = 3, std::size_t maxLength = 12) {
+        std::uniform_int_distribution<std::size_t> length{ minLength, maxLength };
+        std::uniform_int_distribution<int> letter{ 'a', 'z' };
+        std::string result(length(rng), ' ');
+        for (auto& c : result) c = static_cast<char>(letter(rng));
+        return result;
+    }
+
+    // ------------------------------------------------
+
+    // Single object with many members, stresses member lookup and insertion
+    inline std::string wide_object(std::size_t members) {
+        auto rng = generator(1);
+        std::uniform_int_distribution<int> number{ -100000, 100000 };
+        std::string result = "{";
+        for (std::size_t i = 0; i < members; ++i) {
+            if (i != 0) result += ',';
+            result += "\"" + random_word(rng) + std::to_string(i) + "\":";
+            switch (i % 4) {
+            case 0: result += std::to_string(number(rng)); break;
+            case 1: result += "\"" + random_word(rng) + "\""; break;
+            case 2: result += i % 8 == 2 ? "true" : "null"; break;
+            case 3: result += "[" + std::to_string(number(rng)) + "," + std::to_string(number(rng)) + "]"; break;
+            }
+        }
+        return result += "}";
+    }
+
+    // Alternating objects and arrays, stays below the default parser depth limit
+    inline std::string deep_nesting(std::size_t depth, std::size_t repeat) {
+        std::string result = "[";
+        for (std::size_t r = 0; r < repeat; ++r) {
+            if (r != 0) result += ',';
+            for (std::size_t i = 0; i < depth; ++i) result += i % 2 ? "[" : "{\"a\":";
+            result += std::to_string(r);
+            for (std::size_t i = depth; i > 0; --i) result += (i - 1) % 2 ? "]" : "}";
+        }
+        return result += "]";
+    }
+
+    // Array of integers and floating point numbers
+    inline std::string numeric_array(std::size_t elements) {
+        auto rng = generator(2);
+        std::uniform_int_distribution<std::int64_t> integer{ -1'000'000'000, 1'000'000'000 };
+        std::uniform_real_distribution<double> floating{ -1000.0, 1000.0 };
+        std::string result = "[";
+        for (std::size_t i = 0; i < elements; ++i) {
+            if (i != 0) result += ',';
+            if (i % 2) result += std::to_string(integer(rng));
+            else {
+                std::ostringstream stream;
+                stream.precision(17);
+                stream << floating(rng);
+                result += stream.str();
+            }
+        }
+        return result += "]";
+    }
+
+    // Long strings with escape sequences
+    inline std::string string_heavy(std::size_t elements) {
+        auto rng = generator(3);
+        std::string result = "[";
+        for (std::size_t i = 0; i < elements; ++i) {
+            if (i != 0) result += ',';
+            result += '"';
+            for (std::size_t j = 0; j < 16; ++j) {
+                result += random_word(rng);
+                result += j % 5 == 4 ? "\\n" : j % 7 == 6 ? "\\\"" : " ";
+            }
+            result += '"';
+        }
+        return result += "]";
+    }
+
+    // HJSON with comments, quoteless keys and values, and multi-line strings
+    inline std::string hjson_document(std::size_t entries) {
+        auto rng = generator(4);
+        std::string result = "# generated hjson document\n";
+        for (std::size_t i = 0; i < entries; ++i) {
+            std::string key = random_word(rng) + std::to_string(i);
+            switch (i % 4) {
+            case 0: result += "// line comment\n" + key + ": " + random_word(rng) + " " + random_word(rng) + "\n"; break;
+            case 1: result += "/* block\n   comment */\n" + key + ": " + std::to_string(i) + "\n"; break;
+            case 2: result += key + ":\n  '''\n  " + random_word(rng) + "\n  " + random_word(rng) + "\n  '''\n"; break;
+            case 3: result += key + ": {\n  nested: [\n    1\n    2\n  ]\n  flag: true\n}\n"; break;
+            }
+        }
+        return result;
+    }
+
+    // ------------------------------------------------
+
+    inline std::vector<document> synthetic_corpus() {
+        return {
+            { "wide_object", wide_object(10'000) },
+            { "deep_nesting", deep_nesting(128, 256) },
+            { "numeric_array", numeric_array(100'000) },
+            { "string_heavy", string_heavy(10'000) },
+            { "hjson", hjson_document(10'000) },
+        };
+    }
+
+    // Standard documents (twitter.json, canada.json, citm_catalog.json, ...) found in the data directory
+    inline std::vector<document> file_corpus(const std::filesystem::path& directory) {
+        std::vector<document> result;
+        std::error_code error;
+        for (auto& entry : std::filesystem::directory_iterator{ directory, error }) {
+            auto extension = entry.path().extension();
+            if (!entry.is_regular_file() || (extension != ".json" && extension != ".hjson")) continue;
+            std::ifstream file{ entry.path(), std::ios::binary };
+            std::ostringstream text;
+            text << file.rdbuf();
+            result.push_back({ entry.path().stem().string(), std::move(text).str() });
+        }
+        return result;
+    }
+
+    // ------------------------------------------------
+
+}
+
+// ------------------------------------------------
@@ -4,20 +4,48 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cctype>
 #include <charconv>
+#include <cmath>
+#include <coroutine>
+#include <cstdint>
+#include <cstring>
+#include <exception>
 #include <expected>
+#include <limits>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <ranges>
+#include <span>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
 
 // ------------------------------------------------
 
+// Set to 1 to have the parser collect statistics (see basic_json::parser::parse_stats).
+// When 0 the counters and all code updating them compile away.
+#ifndef BASIC_JSON_PARSER_STATS
+#define BASIC_JSON_PARSER_STATS 0
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BASIC_JSON_SSE2 1
+#include <emmintrin.h>
+#else
+#define BASIC_JSON_SSE2 0
+#endif
+
+// ------------------------------------------------
+
 namespace kaixo {
 
     // ------------------------------------------------
@@ -47,35 +75,134 @@ namespace kaixo {
 
     // ------------------------------------------------
 
-    template<std::floating_point Ty>
-    std::string number_to_json_safe_string(Ty value) {
-        std::ostringstream oss;
-        // Force C locale to guarantee '.' decimal separator
-        oss.imbue(std::locale::classic());
+    // String literal as template argument
+    template<std::size_t N>
+    struct fixed_string {
+        char data[N]{};
+
+        consteval fixed_string(const char(&str)[N]) { std::copy_n(str, N, data); }
+        consteval explicit fixed_string(std::string_view str) { std::copy_n(str.data(), N - 1, data); } // Of N - 1 characters
+
+        constexpr std::string_view view() const { return { data, N - 1 }; }
+    };
+
+    // ------------------------------------------------
+
+    // std::generator is not available everywhere yet, this is the minimal synchronous version.
+    template<class Ty>
+    class generator {
+    public:
+        struct promise_type {
+            const Ty* current = nullptr;
+            std::exception_ptr exception;
+
+            generator get_return_object() { return generator{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            std::suspend_always yield_value(const Ty& value) noexcept { current = std::addressof(value); return {}; }
+            void return_void() noexcept {}
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        struct iterator {
+            using value_type = Ty;
+            using difference_type = std::ptrdiff_t;
+
+            std::coroutine_handle<promise_type> handle;
+
+            const Ty& operator*() const { return *handle.promise().current; }
+            iterator& operator++() { resume(handle); return *this; }
+            void operator++(int) { ++*this; }
+            bool operator==(std::default_sentinel_t) const { return handle.done(); }
+        };
+
+        explicit generator(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+        generator(generator&& other) noexcept : _handle(std::exchange(other._handle, {})) {}
+        generator& operator=(generator other) noexcept { std::swap(_handle, other._handle); return *this; }
+        ~generator() { if (_handle) _handle.destroy(); }
+
+        iterator begin() { resume(_handle); return { _handle }; }
+        std::default_sentinel_t end() const { return {}; }
+
+    private:
+        std::coroutine_handle<promise_type> _handle;
+
+        static void resume(std::coroutine_handle<promise_type> handle) {
+            handle.resume();
+            if (auto exception = std::exchange(handle.promise().exception, nullptr)) std::rethrow_exception(exception);
+        }
+    };
+
+    // ------------------------------------------------
+
+    // Lazily started coroutine producing a single value. Can be co_awaited from another 
+    // coroutine, or started with start() and then driven by whatever it awaits.
+    template<class Ty>
+    class task {
+    public:
+        struct promise_type {
+            std::optional<Ty> result;
+            std::exception_ptr exception;
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+
+            struct final_awaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept { return handle.promise().continuation; }
+                void await_resume() noexcept {}
+            };
+
+            task get_return_object() { return task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            final_awaiter final_suspend() noexcept { return {}; }
+            void return_value(Ty value) { result = std::move(value); }
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
 
-        // max_digits10 ensures round-trip safety
-        oss.precision(std::numeric_limits<Ty>::max_digits10);
-        oss << std::defaultfloat << value;
+        explicit task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+        task(task&& other) noexcept : _handle(std::exchange(other._handle, {})) {}
+        task& operator=(task other) noexcept { std::swap(_handle, other._handle); return *this; }
+        ~task() { if (_handle) _handle.destroy(); }
 
-        std::string s = oss.str();
+        void start() { if (!_handle.done()) _handle.resume(); }
+        bool done() const { return _handle.done(); }
 
-        // Trim trailing zeros in decimal form
-        auto dot = s.find('.');
-        if (dot != std::string::npos)
-        {
-            while (!s.empty() && s.back() == '0')
-                s.pop_back();
+        Ty& get() {
+            if (_handle.promise().exception) std::rethrow_exception(_handle.promise().exception);
+            return _handle.promise().result.value();
+        }
 
-            if (!s.empty() && s.back() == '.')
-                s.pop_back();
+        bool await_ready() const noexcept { return _handle.done(); }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+            _handle.promise().continuation = continuation;
+            return _handle;
         }
+        Ty await_resume() { return std::move(get()); }
+
+    private:
+        std::coroutine_handle<promise_type> _handle;
+    };
 
-        return s;
+    // ------------------------------------------------
+
+    // Enough for any number written by number_to_json_chars
+    constexpr std::size_t max_number_chars = 32;
+
+    // Writes max_digits10 significant digits so the value round-trips, always 
+    // with a '.' decimal separator, trailing zeros are left out.
+    template<std::floating_point Ty>
+    std::to_chars_result number_to_json_chars(char* first, char* last, Ty value) {
+        return std::to_chars(first, last, value, std::chars_format::general, std::numeric_limits<Ty>::max_digits10);
     }
 
     template<std::integral Ty>
+    std::to_chars_result number_to_json_chars(char* first, char* last, Ty value) {
+        return std::to_chars(first, last, value);
+    }
+
+    template<class Ty> requires (std::floating_point<Ty> || std::integral<Ty>)
     std::string number_to_json_safe_string(Ty value) {
-        return std::to_string(value);
+        char buffer[max_number_chars];
+        return { buffer, number_to_json_chars(buffer, buffer + max_number_chars, value).ptr };
     }
 
     // ------------------------------------------------
@@ -164,7 +291,7 @@ namespace kaixo {
 
             iterator put(std::pair<std::string, basic_json> value, const_iterator where) {
                 remove(value.first); // remove any old value associated with key
-                return ++this->insert(where, value);
+                return ++this->insert(where, std::move(value));
             }
 
             iterator remove(std::string_view value) {
@@ -191,9 +318,275 @@ namespace kaixo {
         using object_t = map;
         using null_t = std::nullptr_t;
 
+        // Reference-counted, immutable node. Copies of a shared node only copy the
+        // pointer, and the node is cloned one level deep on the first mutation.
+        using shared_t = std::shared_ptr<const basic_json>;
+
+        struct shared_value {
+
+            // ------------------------------------------------
+
+            shared_t node;
+            mutable std::atomic<std::size_t> hash = 0; // Cached structural hash, 0 until computed
+
+            // ------------------------------------------------
+
+            shared_value(shared_t node) : node(std::move(node)) {}
+            shared_value(const shared_value& other) : node(other.node), hash(other.hash.load(std::memory_order_relaxed)) {}
+            shared_value(shared_value&& other) noexcept : node(std::move(other.node)), hash(other.hash.load(std::memory_order_relaxed)) {}
+
+            shared_value& operator=(const shared_value& other) { return *this = shared_value{ other }; }
+            shared_value& operator=(shared_value&& other) noexcept {
+                node = std::move(other.node);
+                hash.store(other.hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                return *this;
+            }
+
+            // ------------------------------------------------
+
+        };
+
+        // ------------------------------------------------
+
+        // Array of only numbers of a single type, stored without a basic_json per element.
+        // Code that needs the elements as basic_json, through a const reference, gets an 
+        // unpacked copy that is built once next to the packed numbers.
+        struct packed_array {
+
+            // ------------------------------------------------
+
+            using values_t = std::variant<std::vector<double>, std::vector<std::uint64_t>, std::vector<std::int64_t>>;
+
+            values_t values;
+            mutable std::atomic<array_t*> unpacked = nullptr;
+
+            // ------------------------------------------------
+
+            packed_array(values_t values) : values(std::move(values)) {}
+            packed_array(const packed_array& other) : values(other.values) {}
+            ~packed_array() { delete unpacked.load(std::memory_order_relaxed); }
+
+            // ------------------------------------------------
+
+            std::size_t size() const { return std::visit([](auto& vec) { return vec.size(); }, values); }
+            number_t operator[](std::size_t index) const { return std::visit([&](auto& vec) { return number_t{ vec[index] }; }, values); }
+
+            array_t to_array() const {
+                return std::visit([](auto& vec) {
+                    array_t result;
+                    result.reserve(vec.size());
+                    for (auto val : vec) result.emplace_back(val);
+                    return result;
+                }, values);
+            }
+
+            // Unpacked copy, built by the first caller. Threads that race to build it agree on one.
+            const array_t& elements() const {
+                if (auto cached = unpacked.load(std::memory_order_acquire)) return *cached;
+                auto result = std::make_unique<array_t>(to_array());
+                array_t* expected = nullptr;
+                if (unpacked.compare_exchange_strong(expected, result.get(), std::memory_order_acq_rel)) return *result.release();
+                return *expected;
+            }
+
+            // Must be called before the packed values are changed in a way the unpacked copy does not
+            // follow, which invalidates references into it that were taken through const access.
+            void invalidate() { delete unpacked.exchange(nullptr, std::memory_order_relaxed); }
+
+            // ------------------------------------------------
+
+            double sum() const {
+                return std::visit([](auto& vec) {
+                    double result = 0;
+                    std::size_t i = 0;
+#if BASIC_JSON_SSE2
+                    if constexpr (std::same_as<std::ranges::range_value_t<decltype(vec)>, double>) {
+                        __m128d a = _mm_setzero_pd(), b = _mm_setzero_pd();
+                        for (; i + 4 <= vec.size(); i += 4) {
+                            a = _mm_add_pd(a, _mm_loadu_pd(vec.data() + i));
+                            b = _mm_add_pd(b, _mm_loadu_pd(vec.data() + i + 2));
+                        }
+
+                        double lanes[2];
+                        _mm_storeu_pd(lanes, _mm_add_pd(a, b));
+                        result = lanes[0] + lanes[1];
+                    }
+#endif
+                    for (; i < vec.size(); ++i) result += static_cast<double>(vec[i]);
+                    return result;
+                }, values);
+            }
+
+            // Smallest (less) or largest number, size must not be 0
+            template<bool Less>
+            double extreme() const {
+                return std::visit([](auto& vec) {
+                    auto result = vec[0];
+                    std::size_t i = 1;
+#if BASIC_JSON_SSE2
+                    if constexpr (std::same_as<std::ranges::range_value_t<decltype(vec)>, double>) {
+                        if (vec.size() >= 4) {
+                            __m128d a = _mm_loadu_pd(vec.data());
+                            for (i = 2; i + 2 <= vec.size(); i += 2) {
+                                __m128d b = _mm_loadu_pd(vec.data() + i);
+                                a = Less ? _mm_min_pd(a, b) : _mm_max_pd(a, b);
+                            }
+
+                            double lanes[2];
+                            _mm_storeu_pd(lanes, a);
+                            result = Less ? std::min(lanes[0], lanes[1]) : std::max(lanes[0], lanes[1]);
+                        }
+                    }
+#endif
+                    for (; i < vec.size(); ++i) result = Less ? std::min(result, vec[i]) : std::max(result, vec[i]);
+                    return static_cast<double>(result);
+                }, values);
+            }
+
+            // Multiplies all numbers by factor, integers are converted to double first. The unpacked 
+            // copy is scaled along, so references into it stay valid.
+            void scale(double factor) {
+                if (!std::holds_alternative<std::vector<double>>(values)) {
+                    values = std::visit([](auto& vec) { return std::vector<double>(vec.begin(), vec.end()); }, values);
+                }
+
+                auto& vec = std::get<std::vector<double>>(values);
+                std::size_t i = 0;
+#if BASIC_JSON_SSE2
+                __m128d multiplier = _mm_set1_pd(factor);
+                for (; i + 2 <= vec.size(); i += 2) {
+                    _mm_storeu_pd(vec.data() + i, _mm_mul_pd(_mm_loadu_pd(vec.data() + i), multiplier));
+                }
+#endif
+                for (; i < vec.size(); ++i) vec[i] *= factor;
+
+                if (auto cached = unpacked.load(std::memory_order_relaxed)) {
+                    for (i = 0; i < vec.size(); ++i) (*cached)[i] = vec[i];
+                }
+            }
+
+            // ------------------------------------------------
+
+        };
+
+        // Owns the packed array, so a basic_json does not grow
+        struct packed_value {
+            std::unique_ptr<packed_array> data;
+
+            packed_value(packed_array::values_t values) : data(std::make_unique<packed_array>(std::move(values))) {}
+            packed_value(const packed_value& other) : data(std::make_unique<packed_array>(*other.data)) {}
+            packed_value(packed_value&&) noexcept = default;
+            packed_value& operator=(const packed_value& other) { return *this = packed_value{ other }; }
+            packed_value& operator=(packed_value&&) noexcept = default;
+        };
+
+        // ------------------------------------------------
+
+        // Number kept as its validated source text, see parser::parse_options::lazy_numbers.
+        // It is converted the first time it is read, and serialized as the original text.
+        struct lazy_number {
+
+            // ------------------------------------------------
+
+            string_t text;
+            mutable number_t converted;
+            mutable std::atomic<std::uint8_t> state = 0; // 0 not converted, 1 converting, 2 converted
+
+            // ------------------------------------------------
+
+            lazy_number(std::string_view text) : text(text) {}
+            lazy_number(const lazy_number& other) : text(other.text) {}
+
+            // ------------------------------------------------
+
+            // Converted value, cached by the first caller. Threads that race to convert 
+            // it compute the same value, only one of them stores it.
+            number_t value() const {
+                if (state.load(std::memory_order_acquire) == 2) return converted;
+                bool negative = text.starts_with('-');
+                std::string_view digits = std::string_view{ text }.substr(negative);
+                number_t result = _number_from_chars(digits, negative, digits.find_first_of(".eE") != std::string_view::npos);
+                std::uint8_t expected = 0;
+                if (state.compare_exchange_strong(expected, 1, std::memory_order_acquire)) {
+                    converted = result;
+                    state.store(2, std::memory_order_release);
+                }
+                return result;
+            }
+
+            // ------------------------------------------------
+
+        };
+
+        // Owns the lazy number, so a basic_json does not grow
+        struct lazy_value {
+            std::unique_ptr<lazy_number> data;
+
+            lazy_value(std::string_view text) : data(std::make_unique<lazy_number>(text)) {}
+            lazy_value(const lazy_value& other) : data(std::make_unique<lazy_number>(*other.data)) {}
+            lazy_value(lazy_value&&) noexcept = default;
+            lazy_value& operator=(const lazy_value& other) { return *this = lazy_value{ other }; }
+            lazy_value& operator=(lazy_value&&) noexcept = default;
+        };
+
+        // ------------------------------------------------
+
+        // Serialized json that is trusted to be valid, see basic_json::raw_json. Serializers splice
+        // the text verbatim (only escaping non-ASCII for ascii_only), reading the value parses it
+        // once into a cached subtree.
+        struct raw_fragment {
+
+            // ------------------------------------------------
+
+            string_t text;
+            mutable std::atomic<basic_json*> expanded = nullptr;
+
+            // ------------------------------------------------
+
+            raw_fragment(string_t text) : text(std::move(text)) {}
+            raw_fragment(const raw_fragment& other) : text(other.text) {}
+            ~raw_fragment() { delete expanded.load(std::memory_order_relaxed); }
+
+            // ------------------------------------------------
+
+            // Parsed value, built by the first caller. Threads that race to build it agree on one.
+            const basic_json& value() const {
+                if (auto cached = expanded.load(std::memory_order_acquire)) return *cached;
+                auto parsed = basic_json::parse(text);
+                if (!parsed.has_value()) throw std::runtime_error("Invalid raw json.");
+                auto result = std::make_unique<basic_json>(std::move(parsed.value()));
+                basic_json* expected = nullptr;
+                if (expanded.compare_exchange_strong(expected, result.get(), std::memory_order_acq_rel)) return *result.release();
+                return *expected;
+            }
+
+            // ------------------------------------------------
+
+        };
+
+        // Owns the raw fragment, so a basic_json does not grow
+        struct raw_value {
+            std::unique_ptr<raw_fragment> data;
+
+            raw_value(string_t text) : data(std::make_unique<raw_fragment>(std::move(text))) {}
+            raw_value(const raw_value& other) : data(std::make_unique<raw_fragment>(*other.data)) {}
+            raw_value(raw_value&&) noexcept = default;
+            raw_value& operator=(const raw_value& other) { return *this = raw_value{ other }; }
+            raw_value& operator=(raw_value&&) noexcept = default;
+        };
+
+        // Already serialized json, for the basic_json(raw_json) constructor
+        struct raw_json {
+            string_t text;
+        };
+
         // ------------------------------------------------
 
-        using value = std::variant<number_t, string_t, boolean_t, array_t, object_t, null_t>;
+        using value = std::variant<number_t, string_t, boolean_t, array_t, object_t, null_t, shared_value, packed_value, lazy_value, raw_value>;
+
+        // Strings up to this size are copied when a shared node is cloned, larger 
+        // strings keep pointing into the shared tree until they are mutated.
+        constexpr static std::size_t shared_string_threshold = 64;
 
         // ------------------------------------------------
 
@@ -202,6 +595,150 @@ namespace kaixo {
 
         // ------------------------------------------------
 
+        // Storage of the actual value, follows the pointer when this node is shared,
+        // and parses raw json the first time it is accessed.
+        const value& _storage() const {
+            const value* storage = &_value;
+            if (auto shared = std::get_if<shared_value>(storage)) storage = &shared->node->_value;
+            if (auto raw = std::get_if<raw_value>(storage)) return raw->data->value()._value;
+            return *storage;
+        }
+
+        value& _storage() {
+            _unshare();
+            _unpack();
+            return _value;
+        }
+
+        const packed_array* _packed() const {
+            auto packed = std::get_if<packed_value>(&_storage());
+            return packed ? packed->data.get() : nullptr;
+        }
+
+        // Raw json, without parsing it
+        const raw_fragment* _raw() const {
+            const value* storage = &_value;
+            if (auto shared = std::get_if<shared_value>(storage)) storage = &shared->node->_value;
+            auto raw = std::get_if<raw_value>(storage);
+            return raw ? raw->data.get() : nullptr;
+        }
+
+        const lazy_number* _lazy() const {
+            auto lazy = std::get_if<lazy_value>(&_storage());
+            return lazy ? lazy->data.get() : nullptr;
+        }
+
+        // Value of a number, lazy numbers are converted on first use
+        number_t _number() const {
+            if (auto lazy = _lazy()) return lazy->value();
+            return std::get<number_t>(_storage());
+        }
+
+        // Digits of a validated number without its sign
+        static number_t _number_from_chars(std::string_view digits, bool negative, bool floating) {
+            if (floating) {
+                // strtod needs a terminated string, copy to the stack for anything of sensible length
+                double val = 0;
+                char buffer[64];
+                if (digits.size() < sizeof(buffer)) {
+                    std::memcpy(buffer, digits.data(), digits.size());
+                    buffer[digits.size()] = '\0';
+                    from_chars(buffer, buffer + digits.size(), val);
+                } else {
+                    std::string text{ digits };
+                    from_chars(text.data(), text.data() + text.size(), val);
+                }
+                return negative ? -val : val;
+            } else {
+                constexpr std::uint64_t smallest = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + 1; // Magnitude of the smallest std::int64_t
+                std::uint64_t val = 0;
+                auto [end, error] = from_chars(digits.data(), digits.data() + digits.size(), val);
+                // Integers that do not fit in 64 bits are converted like floating point numbers
+                if (error != std::errc{} || (negative && val > smallest)) return _number_from_chars(digits, negative, true);
+                if (!negative) return val;
+                if (val == smallest) return std::numeric_limits<std::int64_t>::min(); // Negating smallest overflows
+                return -static_cast<std::int64_t>(val);
+            }
+        }
+
+        // Mutable access to the elements needs them as basic_json
+        void _unpack() {
+            auto packed = std::get_if<packed_value>(&_value);
+            if (!packed) return;
+
+            std::unique_ptr<array_t> unpacked{ packed->data->unpacked.exchange(nullptr) };
+            _value = unpacked ? std::move(*unpacked) : packed->data->to_array();
+        }
+
+        // Replace the shared pointer with a mutable value. Only this level gets copied, 
+        // the children keep pointing into the shared tree. Raw json is replaced by its value.
+        void _unshare() {
+            auto shared = std::get_if<shared_value>(&_value);
+            if (!shared) return _expand();
+
+            shared_t node = std::move(shared->node);
+            if (node.use_count() == 1) { // Nobody else has access, so we can take the value
+                _value = std::move(const_cast<basic_json&>(*node)._value);
+                return _expand();
+            }
+
+            switch (node->type()) {
+            case array: {
+                if (node->_packed()) { // Only numbers, a copy has no children to share
+                    _value = node->_storage();
+                    break;
+                }
+
+                array_t result;
+                result.reserve(node->as<array_t>().size());
+                for (auto& val : node->as<array_t>()) result.push_back(_alias(node, val));
+                _value = std::move(result);
+                break;
+            }
+            case object: {
+                object_t result;
+                for (auto& [key, val] : node->as<object_t>()) result.emplace_back(key, _alias(node, val));
+                _value = std::move(result);
+                break;
+            }
+            default: _value = node->_storage(); break;
+            }
+        }
+
+        void _expand() {
+            auto raw = std::get_if<raw_value>(&_value);
+            if (!raw) return;
+
+            raw->data->value(); // Parses it, unless already done
+            std::unique_ptr<basic_json> expanded{ raw->data->expanded.exchange(nullptr) };
+            _value = std::move(expanded->_value);
+        }
+
+        // Node pointing to a value owned by the shared tree of owner.
+        static basic_json _alias(const shared_t& owner, const basic_json& val) {
+            if (val.is_shared()) return val; // Already shared, copy the pointer
+            if (!val._raw()) { // Raw json is shared without parsing it
+                switch (val.type()) {
+                case string: if (val.size() <= shared_string_threshold) return val; break;
+                case array:
+                case object: break;
+                default: return val; // Cheaper to copy than to share
+                }
+            }
+
+            basic_json result;
+            result._value = shared_value{ shared_t{ owner, &val } };
+            return result;
+        }
+
+        // Copy of one of our own children, shares the child when we are shared.
+        basic_json _copy_child(const basic_json& val) const {
+            if (auto shared = std::get_if<shared_value>(&_value)) return _alias(shared->node, val);
+            return val;
+        }
+
+        // ------------------------------------------------
+
     public:
         template<class Ty> struct type_alias : std::type_identity<null_t> {};
         template<> struct type_alias<object_t>  : std::type_identity<object_t> {};
@@ -247,6 +784,11 @@ namespace kaixo {
         basic_json(const object_t& value) : _value(value) {}
         basic_json(const array_t& value)  : _value(value) {}
         basic_json(std::initializer_list<object_t::value_type> values) : _value(object_t{ values }) {}
+        basic_json(raw_json raw) : _value(raw_value{ std::move(raw.text) }) {}
+        basic_json(shared_t node) {
+            if (node && node->is_shared()) _value = node->_value;
+            else if (node) _value = shared_value{ std::move(node) };
+        }
 
         template<class Ty> requires std::constructible_from<string_t, Ty&&>
         basic_json(Ty&& value)
@@ -267,94 +809,358 @@ namespace kaixo {
         basic_json(const std::vector<Ty>& values)
             : _value(array_t{ values.begin(), values.end() })
         {}
-        
-        // ------------------------------------------------
-        
-        bool operator==(const basic_json& other) const { 
-            if (type() != other.type()) return false;
-            if (!is<number_t>()) return _value == other._value;
-            return std::visit([&](auto a, auto b) { 
-                using common = std::common_type_t<decltype(a), decltype(b)>;
-                return static_cast<common>(a) == static_cast<common>(b); 
-                }, 
-                std::get<number_t>(_value), std::get<number_t>(other._value));
-        }
-
-        // ------------------------------------------------
 
-        type_index type() const { return static_cast<type_index>(_value.index()); }
+        basic_json(const basic_json&) = default;
+        basic_json(basic_json&&) = default;
+        basic_json& operator=(const basic_json&) = default;
+        basic_json& operator=(basic_json&&) = default;
 
-        template<class Ty = void>
-        bool is(type_index t = undefined) const {
-            if constexpr (std::same_as<Ty, void>) return t == type();
-            else return type_index_of<Ty>::value == type();
+        ~basic_json() { 
+            if (_has_nested()) _destroy_nested(); 
         }
 
         // ------------------------------------------------
 
-        bool contains(std::string_view key) const {
-            if (!is<object_t>()) return false;
-            return as<object_t>().contains(key);
+    private:
+        // Owned, non-empty array or object, destroying it destroys more values
+        static bool _is_nested(const basic_json& val) {
+            auto arr = std::get_if<array_t>(&val._value);
+            auto obj = std::get_if<object_t>(&val._value);
+            return (arr && !arr->empty()) || (obj && !obj->empty());
         }
 
-        template<class Ty = void>
-        bool contains(std::string_view key, type_index type = undefined) const {
-            if (!is<object_t>()) return false;
-            auto& obj = as<object_t>();
-            auto value = obj.find(key);
-            return value != obj.end() && value->second.is<Ty>(type);
+        bool _has_nested() const {
+            if (auto arr = std::get_if<array_t>(&_value)) return std::ranges::any_of(*arr, _is_nested);
+            if (auto obj = std::get_if<object_t>(&_value)) return std::ranges::any_of(*obj, [](auto& member) { return _is_nested(member.second); });
+            return false;
         }
 
-        // ------------------------------------------------
-
-        template<class Ty> requires (std::is_arithmetic_v<Ty> && !std::same_as<Ty, bool>)
-        Ty as() const { return std::visit([](auto val) { return static_cast<Ty>(val); }, std::get<number_t>(_value)); }
+        // Destroys nested arrays and objects without recursion or allocation, so destroying
+        // deeply nested values can't overflow the stack and the destructor can't throw. The 
+        // last element of a container is destroyed first, unless it is nested itself, then
+        // the container waits in a chain, linked through that element, until it is destroyed.
+        void _destroy_nested() {
+            value current = std::move(_value);
+            value chain = null_t{};
+            _value = null_t{};
+
+            auto last = [](value& val) -> basic_json* {
+                if (auto arr = std::get_if<array_t>(&val)) return arr->empty() ? nullptr : &arr->back();
+                if (auto obj = std::get_if<object_t>(&val)) return obj->empty() ? nullptr : &obj->back().second;
+                return nullptr;
+            };
 
-        template<class Ty> requires std::is_enum_v<Ty>
-        Ty as() const { return std::visit([](auto val) { return static_cast<Ty>(val); }, std::get<number_t>(_value)); }
+            auto pop = [](value& val) {
+                if (auto arr = std::get_if<array_t>(&val)) arr->pop_back();
+                else std::get<object_t>(val).pop_back();
+            };
 
-        template<std::same_as<boolean_t> Ty>               boolean_t as() const { return std::get<boolean_t>(_value); }
-        template<std::same_as<std::string_view> Ty> std::string_view as() const { return std::get<string_t>(_value); }
+            while (true) {
+                basic_json* back = nullptr;
+                while ((back = last(current)) && !_is_nested(*back)) pop(current);
+
+                if (back) { // Continue with the nested element, its slot links to the chain
+                    value child = std::move(back->_value);
+                    back->_value = std::move(chain);
+                    chain = std::move(current);
+                    current = std::move(child);
+                } else { // Current is empty, continue with the first container in the chain
+                    basic_json* link = last(chain);
+                    if (!link) break;
+                    value next = std::move(link->_value);
+                    pop(chain);
+                    current = std::move(chain);
+                    chain = std::move(next);
+                }
+            }
+        }
 
-        template<std::same_as<string_t> Ty>       string_t& as()       { return std::get<string_t>(_value); }
-        template<std::same_as<string_t> Ty> const string_t& as() const { return std::get<string_t>(_value); }
-        template<std::same_as<object_t> Ty>       object_t& as()       { return std::get<object_t>(_value); }
-        template<std::same_as<object_t> Ty> const object_t& as() const { return std::get<object_t>(_value); }
-        template<std::same_as<array_t> Ty>        array_t&  as()       { return std::get<array_t>(_value); }
-        template<std::same_as<array_t> Ty>  const array_t&  as() const { return std::get<array_t>(_value); }
+    public:
         
         // ------------------------------------------------
+        
+        struct compare_options {
+            bool ignore_key_order = false; // Objects are equal when they have the same members in any order
+        };
 
-    private:
-        template<class Ty>
-        Ty& _get_or_assign() {
-            if (is<null_t>()) _value = Ty{};
-            else if (!is<Ty>()) throw std::runtime_error("Invalid type.");
-            return as<Ty>();
-        }
+        // Numbers compare by their mathematical value, regardless of whether they
+        // are stored as double, std::uint64_t or std::int64_t. So 1, 1u and 1.0 are
+        // all equal and have the same hash, while -1 and 18446744073709551615u are not.
+        bool operator==(const basic_json& other) const { return equals(other, compare_options{}); }
 
-        template<class Ty>
-        const Ty& _get_or_assign() const {
-            if (!is<Ty>()) throw std::runtime_error("Invalid type.");
-            return as<Ty>();
-        }
-    public:
+        bool equals(const basic_json& other, compare_options options) const {
+            if (&_storage() == &other._storage()) return true; // Same shared value
+            if (type() != other.type()) return false;
 
-        // ------------------------------------------------
+            // Only compare hashes when they are already known, calculating them
+            // walks both values, which is as expensive as comparing them.
+            auto a = _cached_hash(), b = other._cached_hash();
+            if (a != 0 && b != 0 && a != b) return false;
 
-        template<class Self>
-        auto& operator[](this Self& self, std::string_view index) {
-            auto& obj = self.template _get_or_assign<object_t>();
-            auto _it = obj.find(index);
-            if (_it == obj.end()) {
-                if constexpr (std::is_const_v<Self>) {
-                    throw std::runtime_error("Invalid key.");
-                } else {
-                    return obj.get_or_insert(index);
+            switch (type()) {
+            case number: return _number_equal(_number(), other._number());
+            case string: return as<string_t>() == other.as<string_t>();
+            case boolean: return as<boolean_t>() == other.as<boolean_t>();
+            case array: {
+                if (!_packed() && !other._packed()) {
+                    return std::ranges::equal(as<array_t>(), other.as<array_t>(), 
+                        [&](auto& a, auto& b) { return a.equals(b, options); });
+                }
+
+                if (size() != other.size()) return false;
+                auto number_at = [](const basic_json& arr, std::size_t index) -> std::optional<number_t> {
+                    if (auto packed = arr._packed()) return (*packed)[index];
+                    auto& val = arr.as<array_t>()[index];
+                    if (!val.is(number)) return std::nullopt;
+                    return val._number();
+                };
+
+                for (std::size_t i = 0; i < size(); ++i) {
+                    auto a = number_at(*this, i), b = number_at(other, i);
+                    if (!a || !b || !_number_equal(*a, *b)) return false;
                 }
+                return true;
             }
-            return _it->second;
-        }
+            case object: {
+                auto& x = as<object_t>();
+                auto& y = other.as<object_t>();
+                if (x.size() != y.size()) return false;
+                if (!options.ignore_key_order) {
+                    return std::ranges::equal(x, y, [&](auto& a, auto& b) { 
+                        return a.first == b.first && a.second.equals(b.second, options); 
+                    });
+                }
+
+                std::unordered_map<std::string_view, const basic_json*> index;
+                index.reserve(y.size());
+                for (auto& [key, val] : y) index.try_emplace(key, &val);
+                return std::ranges::all_of(x, [&](auto& member) {
+                    auto it = index.find(member.first);
+                    return it != index.end() && member.second.equals(*it->second, options);
+                });
+            }
+            default: return true; // null
+            }
+        }
+
+        // ------------------------------------------------
+
+        // Structural hash, consistent with operator== and with equals when ignoring
+        // the key order, as object members are combined independent of their order.
+        // Shared values cache their hash, so hashing a shared document is O(1) after
+        // the first time.
+        std::size_t hash() const {
+            auto shared = std::get_if<shared_value>(&_value);
+            if (shared) {
+                if (auto cached = shared->hash.load(std::memory_order_relaxed)) return cached;
+            }
+
+            std::size_t result = static_cast<std::size_t>(type()) + 1;
+            switch (type()) {
+            case number: result = _hash_combine(result, _hash_number(_number())); break;
+            case string: result = _hash_combine(result, std::hash<std::string_view>{}(as<string_t>())); break;
+            case boolean: result = _hash_combine(result, as<boolean_t>()); break;
+            case array:
+                if (auto packed = _packed()) {
+                    std::visit([&](auto& vec) { for (auto val : vec) result = _hash_combine(result, basic_json{ val }.hash()); }, packed->values);
+                } else {
+                    for (auto& val : as<array_t>()) result = _hash_combine(result, val.hash());
+                }
+                break;
+            case object: {
+                std::size_t members = 0;
+                for (auto& [key, val] : as<object_t>()) {
+                    members += _hash_mix(_hash_combine(std::hash<std::string_view>{}(key), val.hash()));
+                }
+                result = _hash_combine(_hash_combine(result, members), size());
+                break;
+            }
+            default: break;
+            }
+
+            result = _hash_mix(result);
+            if (result == 0) result = 1; // 0 means not yet calculated
+            if (shared) shared->hash.store(result, std::memory_order_relaxed);
+            return result;
+        }
+
+    private:
+        std::size_t _cached_hash() const {
+            auto shared = std::get_if<shared_value>(&_value);
+            return shared ? shared->hash.load(std::memory_order_relaxed) : 0;
+        }
+
+        static std::size_t _hash_mix(std::size_t value) {
+            std::uint64_t x = value; // splitmix64 finalizer
+            x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+            x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+            return static_cast<std::size_t>(x ^ (x >> 31));
+        }
+
+        static std::size_t _hash_combine(std::size_t seed, std::size_t value) {
+            return seed ^ (_hash_mix(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+        }
+
+        // Integral values hash as the integer, no matter the type they are stored as
+        static std::size_t _hash_number(const number_t& number) {
+            return std::visit([](auto val) -> std::size_t {
+                if constexpr (std::floating_point<decltype(val)>) {
+                    if (val == std::trunc(val)) {
+                        if (val >= -0x1p63 && val < 0x1p63) return static_cast<std::size_t>(static_cast<std::int64_t>(val));
+                        if (val >= 0 && val < 0x1p64) return static_cast<std::size_t>(static_cast<std::uint64_t>(val));
+                    }
+                    return _hash_combine(std::hash<double>{}(val), 1);
+                } else {
+                    return static_cast<std::size_t>(val);
+                }
+            }, number);
+        }
+
+        static bool _number_equal(const number_t& a, const number_t& b) {
+            return std::visit([](auto x, auto y) {
+                constexpr bool x_floating = std::floating_point<decltype(x)>;
+                constexpr bool y_floating = std::floating_point<decltype(y)>;
+                if constexpr (x_floating && y_floating) return x == y;
+                else if constexpr (x_floating) return _number_equal(x, y);
+                else if constexpr (y_floating) return _number_equal(y, x);
+                else return std::cmp_equal(x, y);
+            }, a, b);
+        }
+
+        static bool _number_equal(double a, std::integral auto b) {
+            if (a != std::trunc(a)) return false; // Also filters out NaN
+            if constexpr (std::signed_integral<decltype(b)>) return a >= -0x1p63 && a < 0x1p63 && static_cast<std::int64_t>(a) == b;
+            else return a >= 0 && a < 0x1p64 && static_cast<std::uint64_t>(a) == b;
+        }
+
+    public:
+
+        // ------------------------------------------------
+
+        type_index type() const { 
+            auto& storage = _storage();
+            if (std::holds_alternative<packed_value>(storage)) return array;
+            if (std::holds_alternative<lazy_value>(storage)) return number;
+            return static_cast<type_index>(storage.index()); 
+        }
+
+        template<class Ty = void>
+        bool is(type_index t = undefined) const {
+            if constexpr (std::same_as<Ty, void>) return t == type();
+            else return type_index_of<Ty>::value == type();
+        }
+
+        // ------------------------------------------------
+
+        // Moves the value into reference-counted storage. Copies of a shared value are 
+        // O(1) and keep sharing structure until one of them is mutated, at which point
+        // only the nodes on the path to the mutation are copied. References obtained 
+        // through non-const access before sharing should not be used to mutate.
+        basic_json& share() {
+            if (is_shared()) return *this;
+            auto node = std::make_shared<basic_json>();
+            node->_value = std::move(_value);
+            _value = shared_value{ std::move(node) };
+            return *this;
+        }
+
+        bool is_shared() const { return std::holds_alternative<shared_value>(_value); }
+
+        // ------------------------------------------------
+
+        // Text of raw json, which is written as is by the serializers. Raw json is parsed 
+        // once when its value is read, and replaced by that value on mutable access.
+        std::optional<std::string_view> raw_text() const {
+            if (auto raw = _raw()) return raw->text;
+            return std::nullopt;
+        }
+
+        // Source text of a number parsed with parser::parse_options::lazy_numbers
+        std::optional<std::string_view> number_text() const {
+            if (auto lazy = _lazy()) return lazy->text;
+            return std::nullopt;
+        }
+
+        // ------------------------------------------------
+
+        bool contains(std::string_view key) const {
+            if (!is<object_t>()) return false;
+            return as<object_t>().contains(key);
+        }
+
+        template<class Ty = void>
+        bool contains(std::string_view key, type_index type = undefined) const {
+            if (!is<object_t>()) return false;
+            auto& obj = as<object_t>();
+            auto value = obj.find(key);
+            return value != obj.end() && value->second.is<Ty>(type);
+        }
+
+        // ------------------------------------------------
+
+        template<class Ty> requires (std::is_arithmetic_v<Ty> && !std::same_as<Ty, bool>)
+        Ty as() const { return std::visit([](auto val) { return static_cast<Ty>(val); }, _number()); }
+
+        template<class Ty> requires std::is_enum_v<Ty>
+        Ty as() const { return std::visit([](auto val) { return static_cast<Ty>(val); }, _number()); }
+
+        template<std::same_as<boolean_t> Ty>               boolean_t as() const { return std::get<boolean_t>(_storage()); }
+        template<std::same_as<std::string_view> Ty> std::string_view as() const { return std::get<string_t>(_storage()); }
+
+        template<std::same_as<string_t> Ty>       string_t& as()       { return std::get<string_t>(_storage()); }
+        template<std::same_as<string_t> Ty> const string_t& as() const { return std::get<string_t>(_storage()); }
+        template<std::same_as<object_t> Ty>       object_t& as()       { return std::get<object_t>(_storage()); }
+        template<std::same_as<object_t> Ty> const object_t& as() const { return std::get<object_t>(_storage()); }
+        template<std::same_as<array_t> Ty>        array_t&  as()       { return std::get<array_t>(_storage()); }
+        template<std::same_as<array_t> Ty>  const array_t&  as() const { 
+            if (auto packed = _packed()) return packed->elements();
+            return std::get<array_t>(_storage()); 
+        }
+        
+        // ------------------------------------------------
+
+    private:
+        template<class Ty>
+        Ty& _get_or_assign() {
+            if (is<null_t>()) _value = Ty{};
+            else if (!is<Ty>()) throw std::runtime_error("Invalid type.");
+            return as<Ty>();
+        }
+
+        template<class Ty>
+        const Ty& _get_or_assign() const {
+            if (!is<Ty>()) throw std::runtime_error("Invalid type.");
+            return as<Ty>();
+        }
+
+        // Element of a range that can be appended to an array
+        template<class Ty>
+        constexpr static bool _is_element = std::constructible_from<basic_json, Ty>;
+
+        // Key/value pair of a range that can be appended to an object
+        template<class Ty>
+        constexpr static bool _is_member = requires (Ty&& member) {
+            requires std::tuple_size<std::remove_cvref_t<Ty>>::value == 2;
+            { std::get<0>(member) } -> std::convertible_to<std::string_view>;
+            requires std::constructible_from<basic_json, decltype(std::get<1>(std::forward<Ty>(member)))>;
+        };
+    public:
+
+        // ------------------------------------------------
+
+        template<class Self>
+        auto& operator[](this Self& self, std::string_view index) {
+            auto& obj = self.template _get_or_assign<object_t>();
+            auto _it = obj.find(index);
+            if (_it == obj.end()) {
+                if constexpr (std::is_const_v<Self>) {
+                    throw std::runtime_error("Invalid key.");
+                } else {
+                    return obj.get_or_insert(index);
+                }
+            }
+            return _it->second;
+        }
 
         template<class Self>
         auto& operator[](this Self& self, std::size_t index) {
@@ -394,7 +1200,7 @@ namespace kaixo {
         }
         
         std::optional<basic_json> get(std::string_view key) const {
-            return contains(key) ? std::optional{ at(key) } : std::nullopt;
+            return contains(key) ? std::optional{ _copy_child(at(key)) } : std::nullopt;
         }
 
         template<class Ty>
@@ -417,22 +1223,17 @@ namespace kaixo {
         
         template<class Ty>
         bool try_get(std::vector<Ty>& value) const {
-            return foreach([&](auto& v) {
-                if (v.template is<Ty>()) value.emplace_back(v.template as<Ty>());
-            });
+            if (!is<array_t>()) return false;
+            value.reserve(value.size() + size());
+            for (auto&& v : as_range<Ty>()) value.emplace_back(v);
+            return true;
         }
         
         template<class Ty, std::size_t N>
         bool try_get(std::array<Ty, N>& value) const {
             if (size() < N) return false;
             std::array<Ty, N> result{};
-            std::size_t index = 0;
-            foreach([&](auto& v) {
-                if (v.template is<Ty>()) {
-                    if (index == N) return; // too many elements
-                    result[index++] = v.template as<Ty>();
-                }
-            });
+            std::ranges::copy(as_range<Ty>() | std::views::take(N), result.begin()); // stops after N elements
             value = std::move(result);
             return true;
         }
@@ -441,14 +1242,8 @@ namespace kaixo {
         bool try_get(std::vector<Ty>& value) const {
             if (size() < N) return false;
             std::vector<Ty> result;
-            std::size_t index = 0;
-            foreach([&](auto& v) {
-                if (v.template is<Ty>()) {
-                    if (index == N) return; // too many elements
-                    result.emplace_back(v.template as<Ty>());
-                    ++index;
-                }
-            });
+            result.reserve(N);
+            for (auto&& v : as_range<Ty>() | std::views::take(N)) result.emplace_back(v);
             value = std::move(result);
             return true;
         }
@@ -508,35 +1303,261 @@ namespace kaixo {
         
         // ------------------------------------------------
 
+        // Elements of an array, empty when not an array.
+        template<class Self>
+        auto elements(this Self& self) {
+            using element = std::conditional_t<std::is_const_v<Self>, const basic_json, basic_json>;
+            if (!self.template is<array_t>()) return std::span<element>{};
+            return std::span<element>{ self.template as<array_t>() };
+        }
+
+        // Key/value pairs of an object in order, empty when not an object.
+        template<class Self>
+        auto items(this Self& self) {
+            using iterator = decltype(self.template as<object_t>().begin());
+            if (!self.template is<object_t>()) return std::ranges::subrange<iterator>{};
+            auto& obj = self.template as<object_t>();
+            return std::ranges::subrange<iterator>{ obj.begin(), obj.end() };
+        }
+
+        // Elements of an array that are a Ty, converted when iterated. Like try_get it skips other elements.
+        template<class Ty, class Self>
+        auto as_range(this Self& self) {
+            return self.elements()
+                | std::views::filter([](const basic_json& val) { return val.template is<Ty>(); })
+                | std::views::transform([](const basic_json& val) -> decltype(auto) { return val.template as<Ty>(); });
+        }
+
+        // ------------------------------------------------
+
+        // Packs an array of only numbers into a single vector of double, std::uint64_t or 
+        // std::int64_t. Integers and floating point numbers are not mixed, so every number
+        // stays exactly the same. Returns whether the array is packed. The parser packs
+        // numeric arrays when asked to, see parser::parse_options::pack_numbers. Arrays with
+        // lazy numbers are not packed, as that would lose their source text.
+        bool pack() {
+            if (is_packed()) return true;
+            if (!is<array_t>() || empty()) return false;
+
+            auto& arr = as<array_t>();
+            bool floating = false, integral = false, isSigned = false, negative = false, large = false;
+            for (auto& val : arr) {
+                if (!val.is(number) || val._lazy()) return false;
+                std::visit([&]<class Ty>(Ty num) {
+                    if constexpr (std::floating_point<Ty>) floating = true;
+                    else if constexpr (std::signed_integral<Ty>) integral = isSigned = true, negative |= num < 0;
+                    else integral = true, large |= num > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+                }, std::get<number_t>(val._storage()));
+            }
+
+            if ((floating && integral) || (negative && large)) return false;
+
+            auto values = [&]<class Ty>(std::type_identity<Ty>) {
+                std::vector<Ty> result;
+                result.reserve(arr.size());
+                for (auto& val : arr) result.push_back(val.template as<Ty>());
+                return packed_array::values_t{ std::move(result) };
+            };
+
+            if (floating) _value = packed_value{ values(std::type_identity<double>{}) };
+            else if (isSigned && !large) _value = packed_value{ values(std::type_identity<std::int64_t>{}) };
+            else _value = packed_value{ values(std::type_identity<std::uint64_t>{}) };
+            return true;
+        }
+
+        template<class Ty = void>
+        bool is_packed() const {
+            auto packed = _packed();
+            if constexpr (std::same_as<Ty, void>) return packed != nullptr;
+            else return packed && std::holds_alternative<std::vector<Ty>>(packed->values);
+        }
+
+        // Numbers of a packed array, throws when not packed as Ty. The mutable span invalidates
+        // references to elements that were taken through const access before.
+        template<class Ty, class Self> 
+            requires (std::same_as<Ty, double> || std::same_as<Ty, std::uint64_t> || std::same_as<Ty, std::int64_t>)
+        auto as_span(this Self& self) {
+            if (!self.template is_packed<Ty>()) throw std::runtime_error("Invalid type.");
+            if constexpr (std::is_const_v<Self>) {
+                return std::span<const Ty>{ std::get<std::vector<Ty>>(self._packed()->values) };
+            } else {
+                return std::span<Ty>{ self.template _packed_values<Ty>() };
+            }
+        }
+
+        // ------------------------------------------------
+
+        // Sum of the numbers in an array as double, other elements are skipped. Vectorized when packed.
+        double sum() const {
+            if (auto packed = _packed()) return packed->sum();
+            double result = 0;
+            for (double val : as_range<double>()) result += val;
+            return result;
+        }
+
+        std::optional<double> minimum() const { return _extreme<true>(); }
+        std::optional<double> maximum() const { return _extreme<false>(); }
+
+        // Multiplies the numbers in an array by factor, which makes them double. Vectorized when packed.
+        void scale(double factor) {
+            if (_packed()) {
+                _unshare();
+                std::get<packed_value>(_value).data->scale(factor);
+                return;
+            }
+
+            for (auto& val : elements()) if (val.is(number)) val = val.as<double>() * factor;
+        }
+
+    private:
+        // Mutable packed numbers, must be packed as Ty
+        template<class Ty>
+        std::vector<Ty>& _packed_values() {
+            _unshare();
+            auto& packed = *std::get<packed_value>(_value).data;
+            packed.invalidate();
+            return std::get<std::vector<Ty>>(packed.values);
+        }
+
+        template<bool Less>
+        std::optional<double> _extreme() const {
+            if (auto packed = _packed()) return packed->size() ? std::optional{ packed->template extreme<Less>() } : std::nullopt;
+            std::optional<double> result;
+            for (double val : as_range<double>()) result = !result ? val : Less ? std::min(*result, val) : std::max(*result, val);
+            return result;
+        }
+
+    public:
+
+        // ------------------------------------------------
+
+        // Calls fun for all values that are not an object or array, in order.
         template<class Fun, class Self>
         void forall(this Self& self, Fun&& fun) {
-            switch (self.type()) {
-            case object: for (auto& [key, val] : self.template as<object_t>()) val.forall(fun); break;
-            case array: for (auto& val : self.template as<array_t>()) val.forall(fun); break;
-            default: fun(self); break;
+            std::vector<Self*> stack{ &self }; // Explicit stack, deeply nested values can't overflow
+            while (!stack.empty()) {
+                Self* node = stack.back();
+                stack.pop_back();
+                switch (node->type()) {
+                case object: {
+                    auto& obj = node->template as<object_t>();
+                    for (auto it = obj.rbegin(); it != obj.rend(); ++it) stack.push_back(&it->second);
+                    break;
+                }
+                case array: {
+                    auto& arr = node->template as<array_t>();
+                    for (auto it = arr.rbegin(); it != arr.rend(); ++it) stack.push_back(&*it);
+                    break;
+                }
+                default: fun(*node); break;
+                }
             }
         }
         
         // ------------------------------------------------
         
-        void merge(const basic_json& other) {
-            switch (type()) {
-            case object: merge(other, as<object_t>().begin()); break;
-            case null: *this = other; break;
-            default: return; // Can't merge other types
+        struct merge_options {
+            bool overwrite = false;     // Replace existing values with the values of other
+            bool remove_null = false;   // Null in other removes the key (RFC 7396)
+            bool concat_arrays = false; // Append arrays of other to existing arrays
+        };
+
+        // Merges with other, by default only adds keys that do not exist yet
+        // and recursively merges nested objects.
+        void merge(const basic_json& other) { _merge(other, merge_options{}); }
+        void merge(basic_json&& other) { _merge(std::move(other), merge_options{}); }
+        void merge(const basic_json& other, merge_options options) { _merge(other, options); }
+        void merge(basic_json&& other, merge_options options) { _merge(std::move(other), options); }
+
+        // Merges with other, inserts values from other at given iterator
+        object_t::iterator merge(const basic_json& other, object_t::iterator where) { return _merge(other, where, merge_options{}); }
+        object_t::iterator merge(basic_json&& other, object_t::iterator where) { return _merge(std::move(other), where, merge_options{}); }
+        object_t::iterator merge(const basic_json& other, object_t::iterator where, merge_options options) { return _merge(other, where, options); }
+        object_t::iterator merge(basic_json&& other, object_t::iterator where, merge_options options) { return _merge(std::move(other), where, options); }
+
+        // JSON merge patch: https://www.rfc-editor.org/rfc/rfc7396
+        void merge_patch(const basic_json& patch) { merge(patch, { .overwrite = true, .remove_null = true }); }
+        void merge_patch(basic_json&& patch) { merge(std::move(patch), { .overwrite = true, .remove_null = true }); }
+
+        // ------------------------------------------------
+
+    private:
+        template<class Other>
+        void _merge(Other&& other, const merge_options& options) {
+            if (is<object_t>() && other.template is<object_t>()) {
+                _merge(std::forward<Other>(other), as<object_t>().begin(), options);
+            } else if (options.concat_arrays && is<array_t>() && other.template is<array_t>()) {
+                auto& arr = as<array_t>();
+                auto& from = other.template as<array_t>();
+                arr.reserve(arr.size() + from.size());
+                for (auto& val : from) {
+                    if constexpr (std::is_lvalue_reference_v<Other>) arr.push_back(other._copy_child(val));
+                    else arr.push_back(std::move(val));
+                }
+            } else if (is<null_t>() || options.overwrite) {
+                if (options.remove_null && other.template is<object_t>()) { // Also removes nested nulls
+                    _value = object_t{};
+                    _merge(std::forward<Other>(other), as<object_t>().begin(), options);
+                } else {
+                    *this = std::forward<Other>(other);
+                }
             }
         }
 
-        // Merges with other, inserts values from other at given iterator
-        object_t::iterator merge(const basic_json& other, object_t::iterator where) {
-            if (!is<object_t>()) return where; // Don't know where you got that iterator from, but I ain't an object
-            other.foreach([&](const string_t& key, const basic_json& val) {
-                if (!contains(key)) where = as<object_t>().put({ key, val }, where);
-                else if (val.is<object_t>()) this->operator[](key).merge(val);
-            });
+        template<class Other>
+        object_t::iterator _merge(Other&& other, object_t::iterator where, const merge_options& options) {
+            if (!is<object_t>() || !other.template is<object_t>()) return where; // Don't know where you got that iterator from, but I ain't an object
+            auto& obj = as<object_t>();
+            auto& from = other.template as<object_t>();
+
+            // Lookup in the list is linear, so for anything but small objects
+            // use an index to keep the merge linear in the number of keys.
+            const bool indexed = obj.size() * from.size() > 64;
+            std::unordered_map<std::string_view, object_t::iterator> index;
+            if (indexed) {
+                index.reserve(obj.size() + from.size());
+                for (auto it = obj.begin(); it != obj.end(); ++it) index.try_emplace(it->first, it);
+            }
+
+            auto find = [&](std::string_view key) {
+                if (!indexed) return obj.find(key);
+                auto it = index.find(key);
+                return it == index.end() ? obj.end() : it->second;
+            };
+
+            for (auto& [key, val] : from) {
+                auto existing = find(key);
+                if (existing == obj.end()) {
+                    if (options.remove_null && val.is(null)) continue;
+                    auto inserted = obj.emplace(where, std::forward_like<Other>(key), basic_json{});
+                    if (indexed) index.try_emplace(inserted->first, inserted);
+                    _merge_child(inserted->second, other, val, options);
+                } else if (options.remove_null && val.is(null)) {
+                    if (indexed) index.erase(existing->first);
+                    if (existing == where) where = obj.erase(existing);
+                    else obj.erase(existing);
+                } else if (options.overwrite || val.is(object) || (options.concat_arrays && val.is(array))) {
+                    _merge_child(existing->second, other, val, options);
+                }
+            }
+
             return where;
         }
 
+        template<class Other>
+        static void _merge_child(basic_json& target, Other& other, auto& val, const merge_options& options) {
+            if constexpr (!std::is_const_v<Other>) {
+                target._merge(std::move(val), options);
+            } else if (other.is_shared()) { // Keep sharing the nodes of other
+                const basic_json child = other._copy_child(val);
+                target._merge(child, options);
+            } else {
+                target._merge(std::as_const(val), options);
+            }
+        }
+
+    public:
+
         // ------------------------------------------------
 
         template<class Ty> requires std::constructible_from<basic_json, Ty&&>
@@ -557,6 +1578,104 @@ namespace kaixo {
             return operator[](value) = basic_json{ std::forward<Args>(args)... };
         }
 
+        // Adds a member without looking for an existing one, so the key must not be in the object yet.
+        template<class ...Args> requires std::constructible_from<basic_json, Args&&...>
+        basic_json& emplace(std::string_view key, Args&& ...args) {
+            return _get_or_assign<object_t>().emplace_back(string_t{ key }, basic_json{ std::forward<Args>(args)... }).second;
+        }
+
+        // ------------------------------------------------
+
+        // Reserves space for elements, null becomes an empty array. Object members are list 
+        // nodes which are allocated one at a time, so for objects this does nothing.
+        void reserve(std::size_t size) {
+            if (is<object_t>()) return;
+            if (_packed()) {
+                _unshare();
+                std::visit([&](auto& values) { values.reserve(size); }, std::get<packed_value>(_value).data->values);
+                return;
+            }
+
+            _get_or_assign<array_t>().reserve(size);
+        }
+
+        // Appends values to an array, or key/value pairs to an object. Null becomes an array
+        // or object depending on the range. Like put, existing keys get the new value in place.
+        template<std::ranges::input_range R> 
+            requires (_is_element<std::ranges::range_reference_t<R>> || _is_member<std::ranges::range_reference_t<R>>)
+        void append_range(R&& range) {
+            using element = std::remove_cvref_t<std::ranges::range_reference_t<R>>;
+            if constexpr (_is_member<std::ranges::range_reference_t<R>>) {
+                insert_range(_get_or_assign<object_t>().end(), std::forward<R>(range));
+            } else {
+                if constexpr (std::is_arithmetic_v<element> && !std::same_as<element, bool>) {
+                    using number = typename number_type<element>::type;
+                    if (is_packed<number>()) { // Numbers of the same type stay packed
+                        auto& values = _packed_values<number>();
+                        if constexpr (std::ranges::sized_range<R>) values.reserve(values.size() + std::ranges::size(range));
+                        for (auto val : range) values.push_back(static_cast<number>(val));
+                        return;
+                    }
+                }
+
+                insert_range(_get_or_assign<array_t>().end(), std::forward<R>(range));
+            }
+        }
+
+        // Inserts values before where, shifts the elements after it only once. Returns iterator to the first inserted value.
+        template<std::ranges::input_range R> requires _is_element<std::ranges::range_reference_t<R>>
+        array_t::iterator insert_range(array_t::const_iterator where, R&& range) {
+            auto& arr = as<array_t>();
+            std::size_t index = where - arr.cbegin();
+            std::size_t size = arr.size();
+            if constexpr (std::ranges::sized_range<R>) arr.reserve(size + std::ranges::size(range));
+            for (auto&& val : range) arr.emplace_back(std::forward<decltype(val)>(val));
+            std::rotate(arr.begin() + index, arr.begin() + size, arr.end());
+            return arr.begin() + index;
+        }
+
+        // Inserts key/value pairs before where. Like put, existing keys get the new value in place.
+        template<std::ranges::input_range R> requires _is_member<std::ranges::range_reference_t<R>>
+        object_t::iterator insert_range(object_t::iterator where, R&& range) {
+            auto& obj = as<object_t>();
+
+            // Lookup in the list is linear, so for anything but small objects
+            // use an index to keep the insertion linear in the number of keys.
+            // Without a known size the index is only built once the object grows.
+            std::size_t expected = obj.size();
+            if constexpr (std::ranges::sized_range<R>) expected += std::ranges::size(range);
+            bool indexed = false;
+            std::unordered_map<std::string_view, object_t::iterator> index;
+            auto build_index = [&] {
+                indexed = true;
+                index.reserve(std::max(expected, obj.size()));
+                for (auto it = obj.begin(); it != obj.end(); ++it) index.try_emplace(it->first, it);
+            };
+            if (expected > 16) build_index();
+
+            auto find = [&](std::string_view key) {
+                if (!indexed) return obj.find(key);
+                auto it = index.find(key);
+                return it == index.end() ? obj.end() : it->second;
+            };
+
+            std::optional<object_t::iterator> first;
+            for (auto&& member : range) {
+                if (!indexed && obj.size() > 16) build_index();
+                auto existing = find(std::get<0>(member));
+                basic_json val{ std::get<1>(std::forward<decltype(member)>(member)) };
+                if (existing != obj.end()) {
+                    existing->second = std::move(val);
+                } else {
+                    auto inserted = obj.emplace(where, string_t{ std::get<0>(member) }, std::move(val));
+                    if (indexed) index.try_emplace(inserted->first, inserted);
+                    if (!first) first = inserted;
+                }
+            }
+
+            return first.value_or(where);
+        }
+
         // ------------------------------------------------
 
         void remove(std::string_view index) { _get_or_assign<object_t>().remove(index); }
@@ -566,6 +1685,7 @@ namespace kaixo {
         bool empty() const { return size() == 0; }
 
         std::size_t size() const {
+            if (auto packed = _packed()) return packed->size();
             return is<array_t>() ? as<array_t>().size() 
                 : is<object_t>() ? as<object_t>().size() 
                 : is<string_t>() ? as<string_t>().size() : 0ull;
@@ -573,793 +1693,4166 @@ namespace kaixo {
 
         // ------------------------------------------------
 
-        std::string to_string() const {
-            using namespace std::ranges;
-            switch (type()) {
-            case number: return std::visit([](auto& val) { return number_to_json_safe_string(val); }, std::get<number_t>(_value));
-            case string: return '"' + escape(as<string_t>()) + '"';
-            case boolean: return as<boolean_t>() ? "true" : "false";
-            case null: return "null";
-            case array: return '[' + fold_left_first(views::transform(as<array_t>(),
-                    [](auto& v) { return v.to_string(); }),
-                    [](auto&& a, auto&& b) { return a + ',' + b; }).value_or("") + ']';
-            case object: return '{' + fold_left_first(views::transform(as<object_t>(),
-                    [](auto& v) { return '"' + escape(v.first) + "\":" + v.second.to_string(); }), 
-                    [](auto&& a, auto&& b) { return a + ',' + b; }).value_or("") + '}';
-            default: return "";
-            }
+        // JSON Patch: https://www.rfc-editor.org/rfc/rfc6902
+        // Creates a patch that transforms from into to. Objects are matched by key,
+        // arrays are matched using their longest common subsequence, as long as the
+        // LCS table stays within maxArrayCells, otherwise elements are matched by index.
+        static basic_json diff(const basic_json& from, const basic_json& to, std::size_t maxArrayCells = 1'000'000) {
+            array_t patch;
+            std::string path;
+            _diff(from, to, path, patch, maxArrayCells);
+            return patch;
         }
 
-        std::string to_hjson_string() const {
-            using namespace std::ranges;
-            switch (type()) {
-            case number: return std::visit([](auto& val) { return number_to_json_safe_string(val); }, std::get<number_t>(_value));
-            case string: return '"' + escape(as<string_t>()) + '"';
-            case boolean: return as<boolean_t>() ? "true" : "false";
-            case null: return "null";
-            case array: return '[' + fold_left_first(views::transform(as<array_t>(),
-                    [](auto& v) { return v.to_hjson_string(); }),
-                    [](auto&& a, auto&& b) { return a + ',' + b; }).value_or("") + ']';
-            case object: return '{' + fold_left_first(views::transform(as<object_t>(),
-                    [](auto& v) { return escape(v.first) + ":" + v.second.to_hjson_string(); }), 
-                    [](auto&& a, auto&& b) { return a + ',' + b; }).value_or("") + '}';
-            default: return "";
-            }
-        }
-
-        std::string to_pretty_string(std::size_t indent = 0, std::size_t indentSize = 2) {
-            using namespace std::ranges;
-            const std::string spaces(indent * indentSize, ' ');
-            const std::string tab(indentSize, ' ');
-            switch (type()) {
-            case array: {
-                bool hasNestedObject = as<array_t>().end() != std::ranges::find_if(as<array_t>(), [](auto& val) {
-                    return (val.is(basic_json::object) || val.is(basic_json::array)) && !val.empty();
-                });
-
-                if (hasNestedObject) {
-                    return "[\n" + fold_left_first(views::transform(as<array_t>(),
-                        [&](auto& v) { return spaces + tab + v.to_pretty_string(indent + 1, indentSize); }),
-                        [](auto&& a, auto&& b) { return a + ",\n" + b; }).value_or("") + '\n' + spaces + ']';
-                } 
+        // Applies a JSON Patch, when any of the operations fails this value is
+        // left unchanged and false is returned.
+        bool apply_patch(const basic_json& patch) {
+            if (!patch.is<array_t>()) return false;
+            bool wasShared = is_shared();
+            share(); // The copy is O(1), the operations only copy the paths they modify
+            bool applied = [&] {
+                basic_json result = *this;
+                for (auto& operation : patch.as<array_t>()) {
+                    if (!result._apply_operation(operation)) return false;
+                }
+                *this = std::move(result);
+                return true;
+            }();
 
-                return to_string();
-            }
-            case object:
-                if (empty()) return "{}";
-                return "{\n" + fold_left_first(views::transform(as<object_t>(),
-                    [&](auto& v) { return spaces + tab + '"' + escape(v.first) + "\": " + v.second.to_pretty_string(indent + 1, indentSize); }),
-                    [](auto&& a, auto&& b) { return a + ",\n" + b; }).value_or("") + '\n' + spaces + '}';
-            default: return to_string();
-            }
+            // Nothing else refers to the root anymore, so this takes the value back without copying
+            if (!wasShared) _unshare();
+            return applied;
         }
 
         // ------------------------------------------------
 
-        // HJSON parser: https://hjson.github.io/syntax.html
-        struct parser {
+    private:
+        static void _diff(const basic_json& from, const basic_json& to, std::string& path, array_t& patch, std::size_t maxArrayCells) {
+            if (&from._storage() == &to._storage()) return; // Same shared value
 
-            // ------------------------------------------------
+            // Shared values cache their hash, equal hashes are confirmed by comparing
+            auto hashA = from._cached_hash(), hashB = to._cached_hash();
+            if (hashA != 0 && hashA == hashB && from == to) return;
 
-            constexpr static std::string_view whitespace = " \t\n\r\f\v";
-            constexpr static std::string_view whitespace_no_lf = " \t\r\f\v";
+            if (from.type() != to.type() || !(from.is(object) || from.is(array))) {
+                if (from != to) patch.push_back(basic_json{ { "op", "replace" }, { "path", path }, { "value", to } });
+                return;
+            }
 
-            // ------------------------------------------------
-            
-            struct error_message {
+            const std::size_t size = path.size();
+            auto at = [&](auto&& token) -> std::string& {
+                path.resize(size);
+                path += '/';
+                if constexpr (std::integral<std::decay_t<decltype(token)>>) path += std::to_string(token);
+                else _pointer_escape(path, token);
+                return path;
+            };
 
-                // ------------------------------------------------
+            if (from.is(object)) {
+                auto& a = from.as<object_t>();
+                auto& b = to.as<object_t>();
 
-                std::string_view message;
+                std::unordered_map<std::string_view, const basic_json*> index;
+                index.reserve(b.size());
+                for (auto& [key, val] : b) index.try_emplace(key, &val);
 
-                // ------------------------------------------------
+                for (auto& [key, val] : a) {
+                    auto it = index.find(key);
+                    if (it == index.end()) {
+                        patch.push_back(basic_json{ { "op", "remove" }, { "path", at(key) } });
+                    } else {
+                        _diff(val, *it->second, at(key), patch, maxArrayCells);
+                        index.erase(it); // Remaining keys are the ones that were added
+                    }
+                }
 
-                template<std::size_t N> // Consteval enforces error message to be string literal
+                for (auto& [key, val] : b) {
+                    if (index.contains(key)) patch.push_back(basic_json{ { "op", "add" }, { "path", at(key) }, { "value", val } });
+                }
+            } else {
+                auto& a = from.as<array_t>();
+                auto& b = to.as<array_t>();
+
+                // Common prefix and suffix don't need to be part of the LCS
+                std::size_t prefix = 0, suffix = 0;
+                while (prefix < a.size() && prefix < b.size() && a[prefix] == b[prefix]) ++prefix;
+                while (suffix < a.size() - prefix && suffix < b.size() - prefix 
+                    && a[a.size() - suffix - 1] == b[b.size() - suffix - 1]) ++suffix;
+
+                const std::size_t n = a.size() - prefix - suffix;
+                const std::size_t m = b.size() - prefix - suffix;
+                std::size_t index = prefix; // Index in the array while the patch is being applied
+
+                if ((n + 1) * (m + 1) <= maxArrayCells) {
+                    // Elements are only compared in full when their hashes are equal
+                    std::vector<std::size_t> hashA(n), hashB(m);
+                    for (std::size_t i = 0; i < n; ++i) hashA[i] = a[prefix + i].hash();
+                    for (std::size_t j = 0; j < m; ++j) hashB[j] = b[prefix + j].hash();
+
+                    // lcs[i * (m + 1) + j] is the length of the LCS of a[i..n) and b[j..m)
+                    std::vector<std::uint32_t> lcs((n + 1) * (m + 1), 0);
+                    std::vector<bool> equal(n * m, false);
+                    auto table = [&](std::size_t i, std::size_t j) -> std::uint32_t& { return lcs[i * (m + 1) + j]; };
+                    for (std::size_t i = n; i-- > 0;) {
+                        for (std::size_t j = m; j-- > 0;) {
+                            if ((equal[i * m + j] = hashA[i] == hashB[j] && a[prefix + i] == b[prefix + j])) table(i, j) = table(i + 1, j + 1) + 1;
+                            else table(i, j) = std::max(table(i + 1, j), table(i, j + 1));
+                        }
+                    }
+
+                    std::size_t i = 0, j = 0;
+                    while (i < n || j < m) {
+                        if (i < n && j < m && equal[i * m + j]) {
+                            ++i, ++j, ++index;
+                        } else if (i < n && j < m && table(i, j) == table(i + 1, j + 1)) { // Changed element
+                            _diff(a[prefix + i], b[prefix + j], at(index), patch, maxArrayCells);
+                            ++i, ++j, ++index;
+                        } else if (j < m && (i == n || table(i, j + 1) >= table(i + 1, j))) {
+                            patch.push_back(basic_json{ { "op", "add" }, { "path", at(index) }, { "value", b[prefix + j] } });
+                            ++j, ++index;
+                        } else {
+                            patch.push_back(basic_json{ { "op", "remove" }, { "path", at(index) } });
+                            ++i;
+                        }
+                    }
+                } else {
+                    for (std::size_t i = 0; i < std::min(n, m); ++i, ++index) {
+                        _diff(a[prefix + i], b[prefix + i], at(index), patch, maxArrayCells);
+                    }
+
+                    for (std::size_t i = m; i < n; ++i) patch.push_back(basic_json{ { "op", "remove" }, { "path", at(index) } });
+                    for (std::size_t i = n; i < m; ++i, ++index) {
+                        patch.push_back(basic_json{ { "op", "add" }, { "path", at(index) }, { "value", b[prefix + i] } });
+                    }
+                }
+            }
+
+            path.resize(size);
+        }
+
+        // ------------------------------------------------
+
+        bool _apply_operation(const basic_json& operation) {
+            auto member = [&](std::string_view name) -> std::optional<std::string_view> {
+                if (!operation.contains(name, string)) return std::nullopt;
+                return operation.at(name).as<std::string_view>();
+            };
+
+            auto op = member("op");
+            auto path = member("path");
+            auto from = member("from");
+            const basic_json* value = operation.contains("value") ? &operation.at("value") : nullptr;
+            if (!op || !path) return false;
+
+            if (op == "add") return value && _pointer_add(*path, *value);
+            if (op == "remove") return _pointer_remove(*path).has_value();
+            if (op == "replace") {
+                auto target = _pointer(*path);
+                if (!target || !value) return false;
+                *target = *value;
+                return true;
+            }
+            if (op == "move") {
+                if (!from || path->starts_with(std::string{ *from } + '/')) return false;
+                auto moved = _pointer_remove(*from);
+                return moved && _pointer_add(*path, std::move(*moved));
+            }
+            if (op == "copy") {
+                auto source = from ? std::as_const(*this)._pointer(*from) : nullptr;
+                return source && _pointer_add(*path, *source);
+            }
+            if (op == "test") {
+                auto target = std::as_const(*this)._pointer(*path);
+                return target && value && target->equals(*value, { .ignore_key_order = true }); // Member order does not matter
+            }
+
+            return false;
+        }
+
+        // ------------------------------------------------
+
+        // JSON Pointer: https://www.rfc-editor.org/rfc/rfc6901
+        template<class Self>
+        Self* _pointer(this Self& self, std::string_view path) {
+            Self* node = &self;
+            while (!path.empty()) {
+                if (path[0] != '/') return nullptr;
+                path.remove_prefix(1);
+                auto token = path.substr(0, path.find('/'));
+                path.remove_prefix(token.size());
+
+                if (node->is(object)) {
+                    auto& obj = node->template as<object_t>();
+                    auto it = obj.find(_pointer_unescape(token));
+                    if (it == obj.end()) return nullptr;
+                    node = &it->second;
+                } else if (node->is(array)) {
+                    auto& arr = node->template as<array_t>();
+                    auto index = _pointer_index(token);
+                    if (!index || index.value() >= arr.size()) return nullptr;
+                    node = &arr[index.value()];
+                } else {
+                    return nullptr;
+                }
+            }
+
+            return node;
+        }
+
+        bool _pointer_add(std::string_view path, basic_json value) {
+            if (path.empty()) return *this = std::move(value), true;
+            auto split = path.rfind('/');
+            if (split == std::string_view::npos) return false;
+            auto parent = _pointer(path.substr(0, split));
+            if (!parent) return false;
+
+            auto token = _pointer_unescape(path.substr(split + 1));
+            if (parent->is(object)) {
+                (*parent)[token] = std::move(value);
+                return true;
+            } else if (parent->is(array)) {
+                auto& arr = parent->as<array_t>();
+                if (token == "-") return arr.push_back(std::move(value)), true;
+                auto index = _pointer_index(token);
+                if (!index || index.value() > arr.size()) return false;
+                arr.insert(arr.begin() + index.value(), std::move(value));
+                return true;
+            }
+
+            return false;
+        }
+
+        std::optional<basic_json> _pointer_remove(std::string_view path) {
+            auto split = path.rfind('/');
+            if (split == std::string_view::npos) return std::nullopt;
+            auto parent = _pointer(path.substr(0, split));
+            if (!parent) return std::nullopt;
+
+            auto token = _pointer_unescape(path.substr(split + 1));
+            if (parent->is(object)) {
+                auto& obj = parent->as<object_t>();
+                auto it = obj.find(token);
+                if (it == obj.end()) return std::nullopt;
+                basic_json result = std::move(it->second);
+                obj.erase(it);
+                return result;
+            } else if (parent->is(array)) {
+                auto& arr = parent->as<array_t>();
+                auto index = _pointer_index(token);
+                if (!index || index.value() >= arr.size()) return std::nullopt;
+                basic_json result = std::move(arr[index.value()]);
+                arr.erase(arr.begin() + index.value());
+                return result;
+            }
+
+            return std::nullopt;
+        }
+
+        static std::optional<std::size_t> _pointer_index(std::string_view token) {
+            if (token.empty() || (token.size() > 1 && token[0] == '0')) return std::nullopt; // No leading zeroes
+            std::size_t index = 0;
+            auto [end, error] = from_chars(token.data(), token.data() + token.size(), index);
+            if (error != std::errc{} || end != token.data() + token.size()) return std::nullopt;
+            return index;
+        }
+
+        static std::string _pointer_unescape(std::string_view token) {
+            std::string result{ token };
+            string_replace(result, "~1", "/");
+            string_replace(result, "~0", "~");
+            return result;
+        }
+
+        static void _pointer_escape(std::string& path, std::string_view key) {
+            for (char c : key) {
+                if (c == '~') path += "~0";
+                else if (c == '/') path += "~1";
+                else path += c;
+            }
+        }
+
+        // ------------------------------------------------
+
+    public:
+
+        // Index of the first byte that is not part of a well-formed UTF-8 sequence, 
+        // or npos when the whole string is valid UTF-8.
+        static std::size_t find_invalid_utf8(std::string_view str) {
+            auto data = reinterpret_cast<const unsigned char*>(str.data());
+            std::size_t size = str.size();
+            std::size_t i = 0;
+            while (i < size) {
+                // ASCII fast path, skips 16 or 8 bytes at a time while no high bit is set
+#if BASIC_JSON_SSE2
+                while (i + 16 <= size && _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i))) == 0) i += 16;
+#endif
+                while (i + 8 <= size) {
+                    std::uint64_t word;
+                    std::memcpy(&word, data + i, 8);
+                    if (word & 0x8080808080808080ull) break;
+                    i += 8;
+                }
+
+                if (i == size) break;
+                if (data[i] < 0x80) { ++i; continue; }
+
+                auto& lead = _utf8_leads[data[i]];
+                if (lead.length == 0 || i + lead.length > size) return i;
+                if (data[i + 1] < lead.low || data[i + 1] > lead.high) return i;
+                for (std::size_t j = 2; j < lead.length; ++j) {
+                    if ((data[i + j] & 0xC0) != 0x80) return i;
+                }
+
+                i += lead.length;
+            }
+
+            return std::string_view::npos;
+        }
+
+        static bool validate_utf8(std::string_view str) { return find_invalid_utf8(str) == std::string_view::npos; }
+
+        // ------------------------------------------------
+
+    private:
+        struct _utf8_lead {
+            std::uint8_t length; // Sequence length, 0 when not a valid lead byte
+            std::uint8_t low;    // Valid range of the second byte
+            std::uint8_t high;
+        };
+
+        // Well-formed byte sequences, per lead byte (Unicode Table 3-7)
+        constexpr static std::array<_utf8_lead, 256> _utf8_leads = [] {
+            std::array<_utf8_lead, 256> leads{};
+            for (std::size_t c = 0xC2; c <= 0xDF; ++c) leads[c] = { 2, 0x80, 0xBF };
+            for (std::size_t c = 0xE0; c <= 0xEF; ++c) leads[c] = { 3, 0x80, 0xBF };
+            for (std::size_t c = 0xF0; c <= 0xF4; ++c) leads[c] = { 4, 0x80, 0xBF };
+            leads[0xE0].low = 0xA0;  // No overlong encodings
+            leads[0xED].high = 0x9F; // No surrogates
+            leads[0xF0].low = 0x90;  // No overlong encodings
+            leads[0xF4].high = 0x8F; // Nothing above U+10FFFF
+            return leads;
+        }();
+
+        static void _utf8_encode(std::string& out, char32_t codepoint) {
+            if (codepoint < 0x80) {
+                out += static_cast<char>(codepoint);
+            } else if (codepoint < 0x800) {
+                out += static_cast<char>(0xC0 | (codepoint >> 6));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            } else if (codepoint < 0x10000) {
+                out += static_cast<char>(0xE0 | (codepoint >> 12));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (codepoint >> 18));
+                out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+        }
+
+        // Decodes the sequence starting at index, and moves index past it. 
+        // Ill-formed sequences decode to U+FFFD, one byte at a time.
+        static char32_t _utf8_decode(std::string_view str, std::size_t& index) {
+            auto data = reinterpret_cast<const unsigned char*>(str.data());
+            auto& lead = _utf8_leads[data[index]];
+            if (data[index] < 0x80) return data[index++];
+            if (lead.length == 0 || index + lead.length > str.size() 
+                || data[index + 1] < lead.low || data[index + 1] > lead.high) return ++index, 0xFFFD;
+
+            char32_t codepoint = data[index] & (0x7F >> lead.length);
+            for (std::size_t j = 1; j < lead.length; ++j) {
+                if ((data[index + j] & 0xC0) != 0x80) return ++index, 0xFFFD;
+                codepoint = (codepoint << 6) | (data[index + j] & 0x3F);
+            }
+
+            index += lead.length;
+            return codepoint;
+        }
+
+        // Appends \uXXXX, as a surrogate pair when outside the basic multilingual plane
+        static void _unicode_escape(auto& out, char32_t codepoint) {
+            constexpr std::string_view digits = "0123456789abcdef";
+            auto unit = [&](char32_t val) {
+                out += "\\u";
+                for (int shift = 12; shift >= 0; shift -= 4) out += digits[(val >> shift) & 0xF];
+            };
+
+            if (codepoint < 0x10000) return unit(codepoint);
+            codepoint -= 0x10000;
+            unit(0xD800 + (codepoint >> 10));
+            unit(0xDC00 + (codepoint & 0x3FF));
+        }
+
+        // ------------------------------------------------
+
+    public:
+
+        // ------------------------------------------------
+
+        // Iterative serializer, keeps its own stack so deeply nested values can't overflow.
+        // Can write the output in parts, by limiting the size of the output per call.
+        struct serializer {
+
+            // ------------------------------------------------
+
+            struct options {
+                bool hjson = false;      // Keys without quotes
+                bool ascii_only = false; // Escape everything outside ASCII as \uXXXX
+                // Arrays and objects of at least parallel_min_size elements are written in
+                // parts on this many threads by write_parallel. The output is identical.
+                std::size_t threads = 1;
+                std::size_t parallel_min_size = 4096;
+            };
+
+            struct frame {
+                const basic_json* node;
+                std::size_t index = 0;           // Next array element
+                object_t::const_iterator member; // Next object member
+            };
+
+            // Frames of the arrays and objects being written, innermost last. The first levels are
+            // stored inline, so only output nested deeper than inline_size allocates.
+            struct frame_stack {
+                constexpr static std::size_t inline_size = 32;
+
+                std::array<frame, inline_size> inline_frames{};
+                std::vector<frame> spilled{};
+                std::size_t count = 0;
+
+                bool empty() const { return count == 0; }
+                frame& back() { return count <= inline_size ? inline_frames[count - 1] : spilled.back(); }
+
+                void push_back(const frame& value) {
+                    if (count < inline_size) inline_frames[count] = value;
+                    else spilled.push_back(value);
+                    ++count;
+                }
+
+                void pop_back() { if (count-- > inline_size) spilled.pop_back(); }
+            };
+
+            // Output that only counts the characters
+            struct counter {
+                std::size_t size = 0;
+
+                void operator+=(char) { ++size; }
+                void operator+=(std::string_view str) { size += str.size(); }
+            };
+
+            // Output into caller memory, characters past last are dropped
+            struct fixed_buffer {
+                char* first;
+                char* last;
+                bool overflow = false;
+
+                void operator+=(char c) {
+                    if (first == last) overflow = true;
+                    else *first++ = c;
+                }
+
+                void operator+=(std::string_view str) {
+                    std::size_t size = std::min(str.size(), static_cast<std::size_t>(last - first));
+                    first = std::copy_n(str.data(), size, first);
+                    overflow |= size != str.size();
+                }
+            };
+
+            // ------------------------------------------------
+
+            const basic_json* root;
+            options settings{};
+            frame_stack stack{};
+
+            // ------------------------------------------------
+
+            bool done() const { return root == nullptr && stack.empty(); }
+
+            // Appends to out until everything is written, or until out has grown to at least limit
+            // characters. Returns whether everything has been written. Out can also be a counter or
+            // fixed_buffer, which are always written to the end.
+            template<class Out>
+            bool write(Out& out, std::size_t limit = std::string::npos) {
+                if (root) open(*std::exchange(root, nullptr), out);
+                while (!stack.empty() && below(out, limit)) {
+                    frame& top = stack.back();
+                    if (auto packed = top.node->_packed()) {
+                        if (top.index == packed->size()) {
+                            out += ']';
+                            stack.pop_back();
+                            continue;
+                        }
+
+                        if (top.index != 0) out += ',';
+                        write_number(out, (*packed)[top.index++]);
+                    } else if (top.node->is(array)) {
+                        auto& arr = top.node->as<array_t>();
+                        if (top.index == arr.size()) {
+                            out += ']';
+                            stack.pop_back();
+                            continue;
+                        }
+
+                        if (top.index != 0) out += ',';
+                        open(arr[top.index++], out);
+                    } else {
+                        auto& obj = top.node->as<object_t>();
+                        if (top.member == obj.end()) {
+                            out += '}';
+                            stack.pop_back();
+                            continue;
+                        }
+
+                        if (top.member != obj.begin()) out += ',';
+                        auto& [key, val] = *top.member++;
+                        write_key(out, key);
+                        open(val, out); // May invalidate top
+                    }
+                }
+
+                return done();
+            }
+
+            // Writes everything, large arrays and objects are split in parts that
+            // are written on separate threads, and then concatenated.
+            void write_parallel(std::string& out) {
+                if (root) write_parallel(*std::exchange(root, nullptr), out, 0);
+                write(out);
+            }
+
+            template<class Out>
+            void write_key(Out& out, std::string_view key) const {
+                if (settings.hjson && quoteless(key, settings.ascii_only)) out += key, out += ':';
+                else out += '"', escape(out, key, settings.ascii_only), out += "\":";
+            }
+
+            // Whether the parser reads the key back the same without quotes: it must not be empty, 
+            // end early, start a comment, or need escaping.
+            static bool quoteless(std::string_view key, bool asciiOnly) {
+                if (key.empty() || key[0] == '#') return false;
+                return std::ranges::none_of(key, [&](char c) {
+                    auto byte = static_cast<unsigned char>(c);
+                    return byte < 0x20 || (asciiOnly && byte >= 0x80) || std::string_view{ ",:[]{} \\\"'/" }.contains(c);
+                });
+            }
+
+            template<class Out>
+            void write_scalar(Out& out, const basic_json& node) const {
+                switch (node.type()) {
+                case number: write_number(out, node); break;
+                case string: out += '"', escape(out, node.as<string_t>(), settings.ascii_only), out += '"'; break;
+                case boolean: out += node.as<boolean_t>() ? "true" : "false"; break;
+                case null: out += "null"; break;
+                default: break;
+                }
+            }
+
+            // Lazy numbers are written as their source text
+            template<class Out>
+            static void write_number(Out& out, const basic_json& node) {
+                if (auto lazy = node._lazy()) out += std::string_view{ lazy->text };
+                else write_number(out, std::get<number_t>(node._storage()));
+            }
+
+            template<class Out>
+            static void write_number(Out& out, const number_t& number) {
+                char buffer[max_number_chars];
+                std::visit([&](auto val) { 
+                    out += std::string_view{ buffer, number_to_json_chars(buffer, buffer + max_number_chars, val).ptr };
+                }, number);
+            }
+
+            template<class Out>
+            static void escape(Out& out, std::string_view str, bool asciiOnly) {
+                for (std::size_t i = 0; i < str.size(); ++i) {
+                    char c = str[i];
+                    switch (c) {
+                    case '\\': out += "\\\\"; break;
+                    case '\b': out += "\\b"; break;
+                    case '\f': out += "\\f"; break;
+                    case '\n': out += "\\n"; break;
+                    case '\r': out += "\\r"; break;
+                    case '\t': out += "\\t"; break;
+                    case '"': out += "\\\""; break;
+                    case '\'': out += "\\'"; break;
+                    case '/': out += "\\/"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) _unicode_escape(out, static_cast<unsigned char>(c));
+                        else if (asciiOnly && static_cast<unsigned char>(c) >= 0x80) _unicode_escape(out, _utf8_decode(str, i)), --i;
+                        else out += c;
+                        break;
+                    }
+                }
+            }
+
+            // Raw json is copied as it is, except that for asciiOnly everything outside ASCII is
+            // escaped. Valid json only has those in strings, where an escape means the same.
+            template<class Out>
+            static void write_raw(Out& out, std::string_view text, bool asciiOnly) {
+                if (!asciiOnly) {
+                    out += text;
+                    return;
+                }
+
+                std::size_t copied = 0;
+                for (std::size_t i = 0; i < text.size();) {
+                    if (static_cast<unsigned char>(text[i]) < 0x80) {
+                        ++i;
+                        continue;
+                    }
+
+                    out += text.substr(copied, i - copied);
+                    _unicode_escape(out, _utf8_decode(text, i));
+                    copied = i;
+                }
+                out += text.substr(copied);
+            }
+
+            // ------------------------------------------------
+
+        private:
+            // Large nodes are only searched for near the root, so this doesn't recurse deeply
+            constexpr static std::size_t max_parallel_depth = 8;
+
+            void write_parallel(const basic_json& node, std::string& out, std::size_t level) {
+                bool raw = node._raw(), isArray = !raw && node.is(array);
+                if (raw || (!isArray && !node.is(object)) || node._packed() || level == max_parallel_depth || settings.threads < 2) {
+                    root = &node;
+                    write(out);
+                    return;
+                }
+
+                out += isArray ? '[' : '{';
+                if (node.size() < settings.parallel_min_size) { // Small, but might contain large nodes
+                    std::size_t index = 0;
+                    if (isArray) for (auto& val : node.as<array_t>()) {
+                        if (index++ != 0) out += ',';
+                        write_parallel(val, out, level + 1);
+                    } else for (auto& [key, val] : node.as<object_t>()) {
+                        if (index++ != 0) out += ',';
+                        write_key(out, key);
+                        write_parallel(val, out, level + 1);
+                    }
+                } else {
+                    std::size_t parts = std::min(settings.threads, node.size());
+                    std::vector<std::string> buffers(parts);
+                    {
+                        std::vector<std::jthread> workers;
+                        auto part = [&](std::size_t index, auto begin, auto end) {
+                            workers.emplace_back([&, index, begin, end] {
+                                serializer writer{ nullptr, settings };
+                                for (auto it = begin; it != end; ++it) {
+                                    if (it != begin) buffers[index] += ',';
+                                    if constexpr (requires { it->second; }) {
+                                        writer.write_key(buffers[index], it->first);
+                                        writer.root = &it->second;
+                                    } else {
+                                        writer.root = &*it;
+                                    }
+                                    writer.write(buffers[index]);
+                                }
+                            });
+                        };
+
+                        // Elements are divided evenly over the parts
+                        auto split = [&](auto& container) {
+                            auto begin = container.begin();
+                            for (std::size_t i = 0; i < parts; ++i) {
+                                auto end = std::next(begin, (container.size() * (i + 1)) / parts - (container.size() * i) / parts);
+                                part(i, begin, end);
+                                begin = end;
+                            }
+                        };
+
+                        if (isArray) split(node.as<array_t>());
+                        else split(node.as<object_t>());
+                    }
+
+                    for (std::size_t i = 0; i < parts; ++i) {
+                        if (i != 0) out += ',';
+                        out += buffers[i];
+                    }
+                }
+
+                out += isArray ? ']' : '}';
+            }
+
+            template<class Out>
+            static bool below(const Out& out, std::size_t limit) {
+                if constexpr (std::same_as<Out, std::string>) return out.size() < limit;
+                else return true;
+            }
+
+            template<class Out>
+            void open(const basic_json& node, Out& out) {
+                if (auto raw = node._raw()) {
+                    write_raw(out, raw->text, settings.ascii_only);
+                    return;
+                }
+
+                switch (node.type()) {
+                case array: out += '[', stack.push_back({ .node = &node }); break;
+                case object: out += '{', stack.push_back({ .node = &node, .member = node.as<object_t>().begin() }); break;
+                default: write_scalar(out, node); break;
+                }
+            }
+
+            // ------------------------------------------------
+
+        };
+
+        // ------------------------------------------------
+
+        // Writes indented json into one string. With a max_width, the one-line size of every 
+        // array and object is measured once before writing, and used to decide its layout.
+        struct pretty_printer {
+
+            // ------------------------------------------------
+
+            struct options {
+                std::size_t indent = 0;      // Indentation level of the value
+                std::size_t indent_size = 2; // Spaces per level, or columns of a tab for max_width
+                bool tabs = false;           // Indent with a tab per level
+                // Arrays and objects that fit on the rest of their line are written on one line. When 0,
+                // arrays are on one line unless they contain a non-empty array or object, objects never are.
+                std::size_t max_width = 0;
+                bool hjson = false;      // Keys without quotes, no commas at the end of lines
+                bool ascii_only = false; // Escape everything outside ASCII as \uXXXX
+            };
+
+            struct extent {
+                std::size_t size = 0;        // Characters when written on one line
+                std::size_t descendants = 0; // Arrays and objects inside, their extents follow this one
+            };
+
+            // ------------------------------------------------
+
+            const basic_json* root;
+            options settings{};
+            std::vector<extent> extents{}; // Of every array and object, in document order
+            std::size_t next = 0;          // Extent of the next array or object
+            serializer flat{ nullptr };    // Writes values on one line
+
+            // ------------------------------------------------
+
+            void write(std::string& out) {
+                if (!root) return;
+                flat.settings = { .hjson = settings.hjson, .ascii_only = settings.ascii_only };
+                extents.clear();
+                next = 0;
+                if (settings.max_width != 0) {
+                    std::string scratch;
+                    measure(*root, scratch);
+                }
+
+                write(*std::exchange(root, nullptr), out, settings.indent, settings.indent * settings.indent_size);
+            }
+
+            // ------------------------------------------------
+
+        private:
+            static std::size_t number_size(const auto& number) {
+                serializer::counter out;
+                serializer::write_number(out, number);
+                return out.size;
+            }
+
+            std::size_t measure(const basic_json& node, std::string& scratch) {
+                if (auto raw = node._raw()) {
+                    serializer::counter out;
+                    serializer::write_raw(out, raw->text, settings.ascii_only);
+                    return out.size;
+                }
+
+                switch (node.type()) {
+                case number: return number_size(node);
+                case string: 
+                    scratch.clear(), serializer::escape(scratch, node.as<string_t>(), settings.ascii_only);
+                    return scratch.size() + 2;
+                case boolean: return node.as<boolean_t>() ? 4 : 5;
+                case null: return 4;
+                case array: case object: {
+                    std::size_t index = extents.size();
+                    extents.emplace_back();
+                    std::size_t size = node.size() == 0 ? 2 : node.size() + 1; // Brackets and commas
+                    if (auto packed = node._packed()) {
+                        for (std::size_t i = 0; i < packed->size(); ++i) size += number_size((*packed)[i]);
+                    } else if (node.is(array)) {
+                        for (auto& val : node.as<array_t>()) size += measure(val, scratch);
+                    } else for (auto& [key, val] : node.as<object_t>()) {
+                        scratch.clear(), flat.write_key(scratch, key);
+                        size += scratch.size() + measure(val, scratch);
+                    }
+
+                    extents[index] = { .size = size, .descendants = extents.size() - index - 1 };
+                    return size;
+                }
+                default: return 0;
+                }
+            }
+
+            // Whether an array or object is written with an element per line
+            bool expands(const basic_json& node, std::size_t column) const {
+                if (node.empty()) return false;
+                if (settings.max_width != 0) return column + extents[next].size > settings.max_width;
+                if (node.is(object)) return true;
+                if (node._packed()) return false;
+                return std::ranges::any_of(node.as<array_t>(), [](const basic_json& val) {
+                    return !val._raw() && (val.is(basic_json::object) || val.is(basic_json::array)) && !val.empty();
+                });
+            }
+
+            void indent(std::string& out, std::size_t level) const {
+                if (settings.tabs) out.append(level, '\t');
+                else out.append(level * settings.indent_size, ' ');
+            }
+
+            // Column is where the value starts on its line
+            void write(const basic_json& node, std::string& out, std::size_t level, std::size_t column) {
+                bool isArray = !node._raw() && node.is(array);
+                if (!isArray && (node._raw() || !node.is(object))) {
+                    flat.root = &node;
+                    flat.write(out);
+                    return;
+                }
+
+                if (!expands(node, column)) {
+                    if (settings.max_width != 0) next += extents[next].descendants + 1;
+                    flat.root = &node;
+                    flat.write(out);
+                    return;
+                }
+
+                if (settings.max_width != 0) ++next;
+                std::size_t inner = (level + 1) * settings.indent_size;
+                std::size_t index = 0;
+                auto line = [&] {
+                    if (index++ != 0 && !settings.hjson) out += ',';
+                    out += '\n';
+                    indent(out, level + 1);
+                };
+
+                out += isArray ? '[' : '{';
+                if (auto packed = node._packed()) {
+                    for (std::size_t i = 0; i < packed->size(); ++i) {
+                        line();
+                        serializer::write_number(out, (*packed)[i]);
+                    }
+                } else if (isArray) {
+                    for (auto& val : node.as<array_t>()) line(), write(val, out, level + 1, inner);
+                } else for (auto& [key, val] : node.as<object_t>()) {
+                    line();
+                    std::size_t start = out.size();
+                    flat.write_key(out, key);
+                    out += ' ';
+                    write(val, out, level + 1, inner + out.size() - start);
+                }
+
+                out += '\n';
+                indent(out, level);
+                out += isArray ? ']' : '}';
+            }
+
+            // ------------------------------------------------
+
+        };
+
+        // ------------------------------------------------
+
+        std::string to_string() const {
+            std::string result;
+            serializer{ this }.write(result);
+            return result;
+        }
+
+        std::string to_string(serializer::options settings) const {
+            std::string result;
+            serializer{ this, settings }.write_parallel(result);
+            return result;
+        }
+
+        // Length of to_string(settings), computed without allocating (for documents nested less than 
+        // serializer::frame_stack::inline_size levels deep)
+        std::size_t serialized_size() const { return serialized_size({}); }
+        std::size_t serialized_size(serializer::options settings) const {
+            serializer::counter out;
+            serializer{ this, settings }.write(out);
+            return out.size;
+        }
+
+        // Writes to_string(settings) into [first, last) without allocating, like serialized_size. Like 
+        // std::to_chars, returns the end of the output, or last with std::errc::value_too_large when 
+        // it doesn't fit.
+        std::to_chars_result serialize_to(char* first, char* last) const { return serialize_to(first, last, {}); }
+        std::to_chars_result serialize_to(char* first, char* last, serializer::options settings) const {
+            serializer::fixed_buffer out{ first, last };
+            serializer{ this, settings }.write(out);
+            if (out.overflow) return { last, std::errc::value_too_large };
+            return { out.first, std::errc{} };
+        }
+
+        // Matches of a JSONPath query, see basic_json::query
+        std::vector<const basic_json*> select(std::string_view path) const { return query{ path }.select(*this); }
+
+        std::string to_hjson_string() const {
+            std::string result;
+            serializer{ this, { .hjson = true } }.write(result);
+            return result;
+        }
+
+        std::string to_ascii_string() const {
+            std::string result;
+            serializer{ this, { .ascii_only = true } }.write(result);
+            return result;
+        }
+
+        // Yields the serialized value in chunks of exactly chunkSize characters, only the last one 
+        // can be smaller. Long strings and numbers are split over multiple chunks. A chunkSize 
+        // of 0 is taken as 1. A chunk is valid until the next one.
+        generator<std::string_view> to_string_chunks(std::size_t chunkSize) const { return to_string_chunks(chunkSize, {}); }
+        generator<std::string_view> to_string_chunks(std::size_t chunkSize, serializer::options settings) const {
+            chunkSize = std::max<std::size_t>(chunkSize, 1);
+            serializer _serializer{ this, settings };
+            std::string _buffer;
+            std::size_t _offset = 0; // Start of what has not been yielded yet
+            while (true) {
+                if (_buffer.size() - _offset < chunkSize && !_serializer.done()) {
+                    _buffer.erase(0, _offset);
+                    _offset = 0;
+                    _serializer.write(_buffer, chunkSize); // Writes at least 1 character
+                    continue;
+                }
+
+                if (_offset == _buffer.size()) break;
+                std::size_t _size = std::min(chunkSize, _buffer.size() - _offset);
+                co_yield std::string_view{ _buffer }.substr(_offset, _size);
+                _offset += _size;
+            }
+        }
+
+        std::string to_pretty_string(std::size_t indent = 0, std::size_t indentSize = 2) const {
+            return to_pretty_string({ .indent = indent, .indent_size = indentSize });
+        }
+
+        std::string to_pretty_string(pretty_printer::options settings) const {
+            std::string result;
+            pretty_printer{ this, settings }.write(result);
+            return result;
+        }
+
+        // ------------------------------------------------
+
+        class schema;
+
+        // HJSON parser: https://hjson.github.io/syntax.html
+        struct parser {
+
+            // ------------------------------------------------
+
+            constexpr static std::string_view whitespace = " \t\n\r\f\v";
+            constexpr static std::string_view whitespace_no_lf = " \t\r\f\v";
+
+            // ------------------------------------------------
+
+            // Byte range of a parsed value in the source, with the ranges of its elements or members
+            struct source_span {
+                std::size_t begin = 0;
+                std::size_t end = 0;
+                std::vector<source_span> children; // In the order of the array or object
+
+                bool operator==(const source_span&) const = default;
+            };
+
+            // ------------------------------------------------
+
+            struct parse_options {
+                // Maximum nesting of objects and arrays. Strict json is parsed iteratively, so
+                // for that every level costs heap memory instead of stack.
+                std::size_t max_depth = 256;
+                // Maximum nesting for what the recursive parser handles: hjson, schemas, spans, and
+                // reporting errors in malformed input. Keeps adversarial input like [[[[... from 
+                // overflowing the stack, also when max_depth is raised. Only raise it with stack to spare.
+                std::size_t max_recursive_depth = 256;
+                // Reject strings, keys and comments that are not well-formed UTF-8, checked while parsing them.
+                bool validate_utf8 = true;
+                // Root arrays of at least parallel_min_size bytes are parsed in parts on this
+                // many threads. The result is identical to parsing on a single thread.
+                std::size_t threads = 1;
+                std::size_t parallel_min_size = 1 << 20;
+                // Validate while parsing, the parse fails at the first violation.
+                const basic_json::schema* schema = nullptr;
+                // Store arrays of at least packed_min_size numbers packed, see basic_json::pack.
+                bool pack_numbers = false;
+                std::size_t packed_min_size = 16;
+                // Keep numbers as their source text, converted on the first read and serialized 
+                // byte for byte. Arrays of lazy numbers are not packed.
+                bool lazy_numbers = false;
+                // Receives the source range of every value, for basic_json::reparse. Root values are
+                // then always parsed on a single thread.
+                source_span* spans = nullptr;
+            };
+
+            // ------------------------------------------------
+
+            enum class production { 
+                object, array, member, value, ambiguous, number, 
+                json_string, quoteless_string, multiline_string, comment, count 
+            };
+
+            struct parse_stats {
+                std::array<std::size_t, std::to_underlying(production::count)> invocations{}; // Per production
+                std::size_t backtracks = 0;             // Reverts that moved the parser back
+                std::size_t backtracked_bytes = 0;      // Bytes given back by those reverts
+                std::size_t bytes_consumed = 0;         // Including bytes consumed again after backtracking
+                std::array<std::size_t, undefined> nodes{};           // Parsed values, by type_index
+                std::array<std::size_t, undefined> allocations{};     // Heap allocations for node storage, by type_index
+                std::array<std::size_t, undefined> allocated_bytes{}; // Bytes requested by those allocations
+                std::size_t max_depth = 0;              // Deepest nesting of objects and arrays
+
+                std::size_t operator[](production p) const { return invocations[std::to_underlying(p)]; }
+
+                parse_stats& operator+=(const parse_stats& other) {
+                    for (std::size_t i = 0; i < invocations.size(); ++i) invocations[i] += other.invocations[i];
+                    for (std::size_t i = 0; i < nodes.size(); ++i) {
+                        nodes[i] += other.nodes[i];
+                        allocations[i] += other.allocations[i];
+                        allocated_bytes[i] += other.allocated_bytes[i];
+                    }
+                    backtracks += other.backtracks;
+                    backtracked_bytes += other.backtracked_bytes;
+                    bytes_consumed += other.bytes_consumed;
+                    max_depth = std::max(max_depth, other.max_depth);
+                    return *this;
+                }
+            };
+
+            struct no_stats {};
+
+            constexpr static bool stats_enabled = BASIC_JSON_PARSER_STATS;
+            using stats_t = std::conditional_t<stats_enabled, parse_stats, no_stats>;
+
+            // ------------------------------------------------
+            
+            struct error_message {
+
+                // ------------------------------------------------
+
+                std::string_view message;
+
+                // ------------------------------------------------
+
+                template<std::size_t N> // Consteval enforces error message to be string literal
                 consteval error_message(const char(&msg)[N])
                     : message(msg)
                 {}
 
-                // ------------------------------------------------
+                // ------------------------------------------------
+
+            };
+
+            struct error {
+                std::size_t line = 0;
+                std::size_t character = 0;
+                error_message message;
+
+                std::string what() const {
+                    return std::format("line {}, character {}: {}", line, character, message.message);
+                }
+            };
+
+            struct error_result {
+
+                // ------------------------------------------------
+
+                std::string_view parsed_until;
+                error_message message;
+
+                // ------------------------------------------------
+
+                operator error() const {
+                    std::size_t newlines = 1;
+                    std::size_t charsInLine = 1;
+                    for (auto& c : parsed_until) {
+                        ++charsInLine;
+                        if (c == '\n') ++newlines, charsInLine = 1;
+                    }
+
+                    return {
+                        .line = newlines,
+                        .character = charsInLine,
+                        .message = message,
+                    };
+                }
+
+                // ------------------------------------------------
+
+            };
+
+            // Nearly every intermediate result carries at most one error, most of them from 
+            // backtracking, so the first error is stored inline and only more errors allocate.
+            struct error_list {
+
+                // ------------------------------------------------
+
+                std::optional<error_result> first;
+                std::vector<error_result> rest;
+
+                // ------------------------------------------------
+
+                error_list() = default;
+                error_list(std::initializer_list<error_result> errors) { for (auto& error : errors) push_back(error); }
+
+                // ------------------------------------------------
+
+                bool empty() const { return !first.has_value(); }
+                std::size_t size() const { return first ? rest.size() + 1 : 0; }
+
+                void push_back(const error_result& error) {
+                    if (first) rest.push_back(error);
+                    else first = error;
+                }
+
+                void append(const error_list& other) {
+                    if (!other.first) return;
+                    push_back(*other.first);
+                    rest.append_range(other.rest);
+                }
+
+                void append(error_list&& other) {
+                    if (empty()) *this = std::move(other);
+                    else append(other);
+                }
+
+                template<class Fun>
+                void for_each(Fun&& fun) const {
+                    if (first) fun(*first);
+                    for (auto& error : rest) fun(error);
+                }
+
+                // ------------------------------------------------
+
+            };
+
+            // ------------------------------------------------
+
+            template<class Ty = void> struct parse_result;
+            template<class Ty = void> 
+            struct result {
+                std::vector<error> _errors;
+                std::optional<Ty> _value;
+                [[no_unique_address]] stats_t _stats{};
+
+                result(error_message msg)
+                    : _errors{ error{.message = msg } }
+                {}
+                
+                result(Ty&& result)
+                    : _value(std::move(result))
+                {}
+
+                template<class T> requires (!std::same_as<Ty, void> && std::constructible_from<Ty, T>)
+                result(T&& result)
+                    : _value(std::move(result))
+                {}
+
+                template<class T> requires (!std::same_as<Ty, void> && std::constructible_from<Ty, T>)
+                result(parse_result<T>&& result)
+                    : _value(std::move(result._value))
+                {
+                    append_errors(result._errors);
+                }
+                
+                result(parse_result<void>&& result) { append_errors(result._errors); }
+
+                void append_errors(const error_list& errors) {
+                    _errors.reserve(_errors.size() + errors.size());
+                    errors.for_each([&](const error_result& error) { _errors.push_back(error); });
+                }
+
+                const std::vector<error>& errors() const { return _errors; }
+                const stats_t& stats() const { return _stats; }
+                explicit operator bool() const { return _value.has_value(); }
+                bool has_value() const { return _value.has_value(); }
+                Ty& value() { return _value.value(); }
+
+                Ty* operator->() { return &_value.value(); }
+            };
+
+            // ------------------------------------------------
+            
+            enum class parse_result_state {
+                success,     // Parsed successfully 
+                recoverable, // Failed to parse, but continue
+                fatal,       // Fatal parse error, non-recoverable
+            };
+
+            template<class Ty>
+            struct parse_result {
+                error_list _errors;
+                std::optional<Ty> _value;
+                parse_result_state _state;
+
+                parse_result(Ty&& result)
+                    : _value(std::move(result))
+                    , _state(parse_result_state::success)
+                {}
+                
+                template<class T> requires (!std::same_as<T, void> && std::constructible_from<Ty, T>)
+                parse_result(parse_result<T>&& result)
+                    : _errors(std::move(result._errors))
+                    , _value(result.has_value() ? std::optional{ Ty{ std::move(result._value.value()) } } : std::nullopt)
+                    , _state(std::move(result._state))
+                {}
+                
+                parse_result(parse_result<void>&& result)
+                    : _errors(std::move(result._errors))
+                    , _state(std::move(result._state))
+                {}
+
+                bool has_value() const { return _value.has_value(); }
+                Ty& value() { return _value.value(); }
+
+                template<class T, class Self>
+                Self&& merge_errors(this Self&& self, parse_result<T>&& other) {
+                    self._errors.append(std::move(other._errors));
+                    return std::forward<Self>(self);
+                }
+                
+                template<class T, class Self>
+                Self&& merge_errors(this Self&& self, const parse_result<T>& other) {
+                    self._errors.append(other._errors);
+                    return std::forward<Self>(self);
+                }
+
+                bool fatal() const { return _state == parse_result_state::fatal; }
+                bool recoverable() const { return _state == parse_result_state::recoverable; }
+                bool success() const { return _state == parse_result_state::success; }
+
+                // When true, it should return, when false it should continue with the next
+                // potential path. If this returns true, it either succeeded, or was fatal
+                // and it must stop parsing.
+                explicit operator bool() const {
+                    return _state == parse_result_state::success
+                        || _state == parse_result_state::fatal;
+                }
+            };
+            
+            template<>
+            struct parse_result<void> {
+                error_list _errors;
+                parse_result_state _state;
+                
+                template<class T, class Self>
+                Self&& merge_errors(this Self&& self, parse_result<T>&& other) {
+                    self._errors.append(std::move(other._errors));
+                    return std::forward<Self>(self);
+                }
+                
+                template<class T, class Self>
+                Self&& merge_errors(this Self&& self, const parse_result<T>& other) {
+                    self._errors.append(other._errors);
+                    return std::forward<Self>(self);
+                }
+
+                bool has_value() const { return false; }
+                void value() const { return; }
+
+                bool fatal() const { return _state == parse_result_state::fatal; }
+                bool recoverable() const { return _state == parse_result_state::recoverable; }
+                bool success() const { return _state == parse_result_state::success; }
+
+                // When true, it should return, when false it should continue with the next
+                // potential path. If this returns true, it either succeeded, or was fatal
+                // and it must stop parsing.
+                explicit operator bool() const {
+                    return _state == parse_result_state::success
+                        || _state == parse_result_state::fatal;
+                }
+            };
+
+            // ------------------------------------------------
+
+            // Storage taken from a previous document, which the parser uses instead of allocating
+            // new strings, arrays and object members. See basic_json::parse_into.
+            struct recycler {
+
+                // ------------------------------------------------
+
+                std::vector<string_t> strings; // Last one is the first string of the previous document
+                std::vector<array_t> arrays;   // Last one is the first array of the previous document
+                object_t members;              // Unused list nodes
+                std::vector<basic_json::value> pending;
+
+                // ------------------------------------------------
+
+                // Takes all storage of json, visits the values in reverse document order using an 
+                // explicit stack, so the parser gets them back in the order it needs them.
+                void collect(basic_json& json) {
+                    pending.push_back(std::exchange(json._value, null_t{}));
+                    while (!pending.empty()) {
+                        basic_json::value val = std::move(pending.back());
+                        pending.pop_back();
+
+                        if (auto str = std::get_if<string_t>(&val)) {
+                            if (str->capacity() > string_t{}.capacity()) strings.push_back(std::move(*str));
+                        } else if (auto arr = std::get_if<array_t>(&val)) {
+                            if (arr->empty()) {
+                                if (arr->capacity() != 0) arrays.push_back(std::move(*arr));
+                                continue;
+                            }
+
+                            std::size_t index = pending.size(); // The array itself is recycled after its elements
+                            pending.emplace_back();
+                            for (auto& element : *arr) pending.push_back(std::move(element._value));
+                            arr->clear();
+                            pending[index] = std::move(*arr);
+                        } else if (auto obj = std::get_if<object_t>(&val)) {
+                            for (auto& [key, member] : *obj) {
+                                pending.push_back(std::move(key));
+                                pending.push_back(std::move(member._value));
+                            }
+                            members.splice(members.end(), *obj);
+                        }
+                    }
+                }
+
+                // Frees whatever the last document did not reuse
+                void clear() {
+                    strings.clear();
+                    arrays.clear();
+                    members.clear();
+                }
+
+                // ------------------------------------------------
+
+            };
+
+            // ------------------------------------------------
+
+            std::string_view original;
+            std::string_view value = original;
+            parse_options options{};
+            std::size_t depth = 0;
+            [[no_unique_address]] stats_t stats{};
+            std::size_t schema_node = 0; // Node in options.schema for the value being parsed
+            recycler* recycle = nullptr;
+            std::vector<source_span>* spans = nullptr; // Receives the spans of the values parsed next
+
+            // ------------------------------------------------
+
+            // Parser for part of original. Offsets, and so the line and character of errors, are found
+            // from the length of what is left of original, so original has to end where the part ends.
+            static parser for_part(std::string_view original, std::string_view part, const parse_options& options, std::size_t depth) {
+                return parser{ original.substr(0, static_cast<std::size_t>(part.data() + part.size() - original.data())), part, options, depth };
+            }
+
+            static void pack(basic_json& json, const parse_options& options) {
+                if (options.pack_numbers && !options.lazy_numbers && json.is(array) && json.size() >= options.packed_min_size) json.pack();
+            }
+
+            // Only strings that do not fit in the small string buffer take a recycled one, so short
+            // strings and keys leave the buffers to the long strings of the document
+            string_t new_string(std::size_t size) {
+                if (!recycle || recycle->strings.empty() || size <= string_t{}.capacity()) return {};
+                string_t _result = std::move(recycle->strings.back());
+                recycle->strings.pop_back();
+                _result.clear();
+                return _result;
+            }
+
+            array_t new_array() {
+                if (!recycle || recycle->arrays.empty()) return {};
+                array_t _result = std::move(recycle->arrays.back());
+                recycle->arrays.pop_back();
+                return _result;
+            }
+
+            void add_member(object_t& object, std::pair<string_t, basic_json>&& member) {
+                if (!recycle || recycle->members.empty()) {
+                    object.put(std::move(member), object.end());
+                    return;
+                }
+
+                object.remove(member.first); // Later duplicate keys replace earlier ones
+                object.splice(object.end(), recycle->members, recycle->members.begin());
+                object.back() = std::move(member);
+            }
+
+            // ------------------------------------------------
+
+            struct nesting {
+                parser* self;
+                ~nesting() { --self->depth; }
+            };
+
+            nesting nest() { 
+                ++depth; 
+#if BASIC_JSON_PARSER_STATS
+                stats.max_depth = std::max(stats.max_depth, depth);
+#endif
+                return { this }; 
+            }
+
+            // ------------------------------------------------
+
+            void count([[maybe_unused]] production p) {
+#if BASIC_JSON_PARSER_STATS
+                ++stats.invocations[std::to_underlying(p)];
+#endif
+            }
+
+            void count_node([[maybe_unused]] type_index type) {
+#if BASIC_JSON_PARSER_STATS
+                ++stats.nodes[type];
+#endif
+            }
+
+            void count_allocation([[maybe_unused]] type_index type, [[maybe_unused]] std::size_t bytes) {
+#if BASIC_JSON_PARSER_STATS
+                ++stats.allocations[type];
+                stats.allocated_bytes[type] += bytes;
+#endif
+            }
+
+            void count_string(const string_t& str) {
+                count_node(string);
+                if (str.capacity() > string_t{}.capacity()) count_allocation(string, str.capacity() + 1);
+            }
+
+            void count_consumed([[maybe_unused]] std::size_t bytes) {
+#if BASIC_JSON_PARSER_STATS
+                stats.bytes_consumed += bytes;
+#endif
+            }
+
+            void count_backtrack([[maybe_unused]] std::string_view from) {
+#if BASIC_JSON_PARSER_STATS
+                if (from.size() == value.size()) return; // Nothing consumed, nothing to backtrack
+                ++stats.backtracks;
+                stats.backtracked_bytes += from.size() - value.size();
+#endif
+            }
+
+            // ------------------------------------------------
+
+            struct backup_struct {
+
+                // ------------------------------------------------
+
+                parser* self;
+                std::string_view backup;
+
+                // ------------------------------------------------
+
+                void do_revert() { self->value = backup; }
+
+                // ------------------------------------------------
+
+                parse_result<> revert_as_success() {
+                    do_revert();
+                    return { 
+                        ._state = parse_result_state::success,
+                    };
+                }
+                
+                parse_result<> warning(error_message message) {
+                    std::string_view parsed = self->original.substr(0, self->original.size() - self->value.size());
+                    do_revert();
+                    return { 
+                        ._errors = { error_result{ parsed, message } },
+                        ._state = parse_result_state::success,
+                    };
+                }
+                
+                parse_result<> revert(error_message message) {
+                    std::string_view parsed = self->original.substr(0, self->original.size() - self->value.size());
+                    self->count_backtrack(backup);
+                    do_revert();
+                    return { 
+                        ._errors = { error_result{ parsed, message } },
+                        ._state = parse_result_state::recoverable,
+                    };
+                }
+                
+                parse_result<> fail(error_message message) {
+                    std::string_view parsed = self->original.substr(0, self->original.size() - self->value.size());
+                    do_revert();
+                    return { 
+                        ._errors = { error_result{ parsed, message } },
+                        ._state = parse_result_state::fatal,
+                    };
+                }
+                
+                parse_result<> revert() {
+                    self->count_backtrack(backup);
+                    do_revert();
+                    return { 
+                        ._state = parse_result_state::recoverable,
+                    };
+                }
+                
+                parse_result<> fail() {
+                    do_revert();
+                    return { 
+                        ._state = parse_result_state::fatal,
+                    };
+                }
+
+                // ------------------------------------------------
+
+            };
+
+            // ------------------------------------------------
+
+            backup_struct backup() { return backup_struct{ this, value }; }
+            parse_result<> success() { return backup().revert_as_success(); }
+            parse_result<> revert(error_message message) { return backup().revert(message); }
+            parse_result<> revert() { return backup().revert(); }
+            parse_result<> fail(error_message message) { return backup().fail(message); }
+            parse_result<> fail() { return backup().fail(); }
+            parse_result<> warning(error_message message) { return backup().warning(message); }
+
+            // ------------------------------------------------
+
+            std::optional<char> consume_one_of(std::string_view chars) {
+                if (value.empty() || !one_of(value[0], chars)) return std::nullopt;
+                char result = value[0];
+                value = value.substr(1);
+                count_consumed(1);
+                return result;
+            }
+            
+            bool consume(std::string_view word) {
+                if (!value.starts_with(word)) return false;
+                value = value.substr(word.size());
+                count_consumed(word.size());
+                return true;
+            }
+
+            std::string_view consume_first(std::size_t i) {
+                std::size_t _end = std::min(i, value.size());
+                auto _result = value.substr(0, _end);
+                value = value.substr(_end);
+                count_consumed(_end);
+                return _result;
+            }
+            
+            std::optional<char32_t> consume_hex4() {
+                std::uint16_t _result = 0;
+                auto _end = value.data() + std::min<std::size_t>(4, value.size());
+                auto [ptr, error] = std::from_chars(value.data(), _end, _result, 16);
+                if (error != std::errc{} || ptr != value.data() + 4) return std::nullopt;
+                consume_first(4);
+                return _result;
+            }
+
+            std::string_view consume_while(std::string_view oneOfs) { return consume_first(value.find_first_not_of(oneOfs)); }
+            std::string_view consume_while_not(std::string_view oneOfs) { return consume_first(value.find_first_of(oneOfs)); }
+
+            // ------------------------------------------------
+            
+            std::size_t nof_characters_since_last(char find) const {
+                std::size_t parsed = original.size() - value.size();
+                std::size_t index = original.substr(0, parsed).find_last_of(find);
+                if (index == std::string_view::npos) return std::string_view::npos;
+                return parsed - index - 1;
+            }
+
+            // ------------------------------------------------
+
+            void ignore(std::string_view anyOf = whitespace) { consume_while(anyOf); }
+
+            // Strings, keys and comments are the only place for anything outside ASCII, so they check
+            // what they consume instead of a separate pass over the input. Fails at the invalid byte.
+            std::optional<parse_result<>> invalid_utf8(std::string_view consumed) {
+                if (!options.validate_utf8) return std::nullopt;
+                std::size_t _invalid = find_invalid_utf8(consumed);
+                if (_invalid == std::string_view::npos) return std::nullopt;
+                value = original.substr(static_cast<std::size_t>(consumed.data() + _invalid - original.data()));
+                return fail("Invalid UTF-8 sequence");
+            }
+
+            parse_result<> removeIgnored(bool newline = true) {
+                auto _result = parse_comment(newline);
+                if (_result.fatal()) return fail().merge_errors(_result);
+                ignore(newline ? whitespace : whitespace_no_lf);
+                return revert(); // Revert just means it should continue (no success, but also no fatal, just neutral; continue)
+            }
+
+            // ------------------------------------------------
+
+            template<class Lambda, class Assign>
+            auto maybe(Lambda&& fun, Assign&& assign) {
+                auto result = fun();
+                if (result.has_value()) {
+                    if constexpr (std::invocable<Assign, decltype(std::move(result.value()))>) {
+                        assign(std::move(result.value()));
+                    } else {
+                        assign = std::move(result.value());
+                    }
+                }
+                return result;
+            }
+
+            // ------------------------------------------------
+
+            template<class Lambda, class Assign>
+            auto parse_list(Lambda&& fun, Assign&& assign) {
+                auto _result = maybe(fun, assign);
+                if (_result.fatal()) return _result;
+
+                while (true) {
+                    { // First try comma
+                        auto _ = backup(); 
+                        if (auto _ignored = removeIgnored()) {
+                            return std::move(_result).merge_errors(_ignored);
+                        }
+
+                        if (consume(",")) {
+                            auto _next = maybe(fun, assign);
+                            if (_next.fatal()) return std::move(_next).merge_errors(_result);
+                            if (_next.success()) {
+                                _result.merge_errors(_next);
+                                continue;
+                            }
+
+                            return _result; // Do not add last error, as this just means we're done parsing the list
+                        }
+                        _.revert();
+                    }
+                    { // Otherwise try LF
+                        auto _ = backup();
+                        if (auto _ignored = removeIgnored(false)) {
+                            return std::move(_result).merge_errors(_ignored);
+                        }
+
+                        if (consume("\n")) {
+                            auto _next = maybe(fun, assign);
+                            if (_next.fatal()) return std::move(_next).merge_errors(_result);
+                            if (_next.success()) {
+                                _result.merge_errors(_next);
+                                continue;
+                            }
+
+                            return _result;  // Do not add last error, as this just means we're done parsing the list
+                        }
+                        _.revert();
+                    }
+                    return _result;
+                }
+            }
+
+            // ------------------------------------------------
+
+            parse_result<int> parse_comment(bool newline = true) {
+                count(production::comment);
+                for (int nofCommentsParsed = 0;; ++nofCommentsParsed) {
+                    auto _ = backup();
+
+                    auto _startedHere = backup().fail("Started here");
+                    ignore(newline ? whitespace : whitespace_no_lf);
+                    if (consume("#") || consume("//")) {
+                        if (auto _invalid = invalid_utf8(consume_while_not("\n"))) return _.fail().merge_errors(*_invalid);
+                    } else if (consume("/*")) {
+                        bool closed = false;
+                        while (!value.empty()) {
+                            if (auto _invalid = invalid_utf8(consume_while_not("*"))) return _.fail().merge_errors(*_invalid);
+                            if (consume("*") && consume("/")) { closed = true; break; }
+                        }
+                        if (!closed) return _.fail("Expected end of multi-line comment").merge_errors(_startedHere);
+                    } else {
+                        if (nofCommentsParsed == 0) return _.revert(); // No more comments
+                        else return nofCommentsParsed;
+                    }
+                }
+            }
+
+            // ------------------------------------------------
+
+            parse_result<basic_json> parse_number() {
+                count(production::number);
+                auto _ = backup();
+
+                if (auto _ignored = removeIgnored()) return _ignored;
+
+                const char* _start = value.data();
+                bool negative = consume("-"), hasExponent = false, fractional = false;
+                const char* _begin = value.data(); // Number without sign, converted in place
+
+                if (!consume("0") && consume_while("0123456789").empty()) return _.revert("Expected at least 1 digit in number");
+
+                if ((fractional = consume("."))) {
+                    if (consume_while("0123456789").empty()) return _.fail("Expected at least 1 decimal digit");
+                }
+
+                if ((hasExponent = static_cast<bool>(consume_one_of("eE")))) {
+                    consume_one_of("+-");
+                    if (consume_while("0123456789").empty()) return _.fail("Expected at least 1 exponent digit");
+                }
+
+                if (options.lazy_numbers) {
+                    parse_result<basic_json> _result = basic_json{};
+                    _result.value()._value = lazy_value{ { _start, static_cast<std::size_t>(value.data() - _start) } };
+                    auto& _text = _result.value()._lazy()->text;
+                    count_allocation(number, sizeof(lazy_number) + (_text.capacity() > string_t{}.capacity() ? _text.capacity() + 1 : 0));
+                    return _result;
+                }
+
+                std::string_view _digits{ _begin, static_cast<std::size_t>(value.data() - _begin) };
+                return basic_json{ _number_from_chars(_digits, negative, fractional || hasExponent) };
+            }
+
+            // ------------------------------------------------
+
+            parse_result<string_t> parse_json_string() {
+                count(production::json_string);
+                auto _ = backup();
+                parse_result<string_t> _result = string_t{};
+
+                if (auto _ignored = removeIgnored()) return _ignored;
+
+                auto v = consume_one_of("\"'");
+                if (!v) return _.revert("Expected \" or ' to start json string");
+                bool smallQuote = v == '\'';
+                auto _chunk = consume_while_not(smallQuote ? "'\\" : "\"\\");
+                _result.value() = new_string(_chunk.size()); // Most strings have no escapes, so usually their size
+                while (true) {
+                    if (auto _invalid = invalid_utf8(_chunk)) return _.fail().merge_errors(*_invalid);
+                    _result.value() += _chunk;
+                    if (consume(smallQuote ? "\'" : "\"")) { // String ended
+                        count_string(_result.value());
+                        return _result; 
+                    }
+                    if (!consume("\\")) break; // Input ended, escaped character otherwise
+                    if (consume("\"")) _result.value() += "\"";
+                    else if (consume("\'")) _result.value() += "\'";
+                    else if (consume("\\")) _result.value() += "\\";
+                    else if (consume("/")) _result.value() += "/";
+                    else if (consume("b")) _result.value() += "\b";
+                    else if (consume("f")) _result.value() += "\f";
+                    else if (consume("n")) _result.value() += "\n";
+                    else if (consume("r")) _result.value() += "\r";
+                    else if (consume("t")) _result.value() += "\t";
+                    else if (consume("u")) {
+                        auto _unit = consume_hex4();
+                        if (!_unit) return _.fail("Expected 4 hexadecimal digits after \\u");
+
+                        char32_t _codepoint = *_unit;
+                        if (_codepoint >= 0xD800 && _codepoint <= 0xDBFF) { // High surrogate, must be followed by a low surrogate
+                            auto _low = backup();
+                            std::optional<char32_t> _next;
+                            if (consume("\\u") && (_next = consume_hex4()) && *_next >= 0xDC00 && *_next <= 0xDFFF) {
+                                _codepoint = 0x10000 + ((_codepoint - 0xD800) << 10) + (*_next - 0xDC00);
+                            } else {
+                                _low.do_revert();
+                                _result.merge_errors(warning("Unpaired surrogate in \\u escape"));
+                                _codepoint = 0xFFFD;
+                            }
+                        } else if (_codepoint >= 0xDC00 && _codepoint <= 0xDFFF) {
+                            _result.merge_errors(warning("Unpaired surrogate in \\u escape"));
+                            _codepoint = 0xFFFD;
+                        }
+
+                        _utf8_encode(_result.value(), _codepoint);
+                    }
+                    else return _result.merge_errors(warning("Wrong escape character"));
+                    _chunk = consume_while_not(smallQuote ? "'\\" : "\"\\");
+                }
+
+                return _.fail("Expected \" or ' to end json string");
+            }
+
+            parse_result<string_t> parse_quoteless_string() {
+                count(production::quoteless_string);
+                auto _ = backup();
+                if (auto _ignored = removeIgnored()) return _ignored;
+                
+                if (consume_one_of("[]{},:")) return _.revert("Quoteless string cannot start with any of \"[]{},:\"");
+                auto _result = consume_while_not("\n");
+                if (auto _invalid = invalid_utf8(_result)) return _.fail().merge_errors(*_invalid);
+                _result = _result.substr(0, _result.find_last_not_of(whitespace) + 1); // Remove whitespace from end
+                string_t _str = new_string(_result.size());
+                _str = _result;
+                count_string(_str);
+                return _str;
+            }
+            
+            parse_result<string_t> parse_multiline_string() {
+                count(production::multiline_string);
+                auto _ = backup();
+                if (auto _ignored = removeIgnored()) return _ignored;
+                string_t _result = "";
+
+                std::size_t _columnsBeforeStart = nof_characters_since_last('\n');
+                if (_columnsBeforeStart == std::string_view::npos) {
+                    // If no previous newline, it means we're on the first line, so just count nof parsed characters
+                    _columnsBeforeStart = original.size() - value.size();
+                }
+                
+                auto _startedHere = backup().fail("Started here");
+                if (!consume("'''")) return _.revert("Expected ''' to start multi-line string");
+                ignore(whitespace_no_lf);
+                bool startsOnNewLine = consume("\n");
+
+                bool firstLine = true;
+                while (!value.empty()) {
+                    ignore(whitespace_no_lf);
+                    if (consume("'''")) { // End of string
+                        count_string(_result);
+                        return _result;
+                    }
+
+                    std::size_t index = nof_characters_since_last('\n');
+                    if (_columnsBeforeStart == std::string_view::npos) {
+                        // If no previous newline, it means we're on the first line, so just count nof parsed characters
+                        _columnsBeforeStart = original.size() - value.size();
+                    }
+
+                    std::int64_t spaces = std::max(static_cast<std::int64_t>(index) - static_cast<std::int64_t>(_columnsBeforeStart), static_cast<std::int64_t>(0ll));
+                    if (firstLine && !startsOnNewLine) spaces -= 3; // remove 3 spaces to account for ''' on first line
+                    
+                    if (!firstLine) _result += '\n';
+                    else firstLine = false;
+
+                     _result += std::string(spaces, ' ');
+                    while (!value.empty()) {
+                        auto _line = consume_while_not("\n'");
+                        if (auto _invalid = invalid_utf8(_line)) return _.fail().merge_errors(*_invalid);
+                        _result += _line;
+                        if (consume("'''")) { // End of string
+                            count_string(_result);
+                            return _result;
+                        } else if (consume("'")) _result += "'"; // ' inside string
+                        else if (consume("\n")) break;      // End of line
+                    }
+                }
+
+                return _.fail("Expected ''' to end multi-line string")
+                        .merge_errors(_startedHere);
+            }
+
+            // ------------------------------------------------
+
+            parse_result<std::pair<string_t, basic_json>> parse_member() {
+                count(production::member);
+                auto _ = backup();
+                parse_result<std::pair<string_t, basic_json>> _result = std::pair<string_t, basic_json>{};
+                string_t& _key = _result.value().first;
+                basic_json& _val = _result.value().second;
+
+                if (auto _ignored = removeIgnored()) return _ignored;
+
+                auto _keyResult = parse_json_string();
+                if (_keyResult.fatal()) return _.fail().merge_errors(_keyResult);
+
+                if (_keyResult.has_value()) {
+                    _result.merge_errors(_keyResult);
+                    _key = std::move(_keyResult.value()); 
+                } else {
+                    auto _quoteless = consume_while_not(",:[]{} \t\n\r\f\v");
+                    if (auto _invalid = invalid_utf8(_quoteless)) return _.fail().merge_errors(*_invalid).merge_errors(_result);
+                    _key = new_string(_quoteless.size());
+                    _key = _quoteless;
+                }
+
+                if (_key.empty()) {
+                    return _.revert("Cannot have empty key")
+                            .merge_errors(_result);
+                }
+
+                if (auto _ignored = removeIgnored()) {
+                    return std::move(_ignored).merge_errors(_result);
+                }
+
+                if (!consume(":")) {
+                    return _.fail("Expected ':' after key")
+                            .merge_errors(_result);
+                }
+
+                std::size_t _objectNode = schema_node;
+                if (options.schema) {
+                    auto _property = options.schema->property(schema_node, _key);
+                    if (!_property) return _.fail("Property is not allowed by the schema").merge_errors(_result);
+                    schema_node = *_property;
+                }
+
+                auto _valueResult = parse_value();
+                schema_node = _objectNode;
+                _result.merge_errors(_valueResult);
+                if (_valueResult.has_value()) {
+                    _val = std::move(_valueResult.value());
+                } else if (_valueResult.fatal()) {
+                    return _.fail()
+                            .merge_errors(_result);
+                }
+
+                return _result;
+            }
+
+            // ------------------------------------------------
+
+            parse_result<object_t> parse_object(bool rootValue) {
+                count(production::object);
+                auto _ = backup();
+                parse_result<object_t> _result = object_t{};
+
+                if (auto _ignored = removeIgnored()) return _ignored;
+
+                bool startedWithBrace = true;
+                if (!consume("{")) {
+                    if (rootValue && starts_with_member()) {
+                        startedWithBrace = false;
+                    } else {
+                        return _.revert("Expected '{' to begin Object");
+                    }
+                }
+
+                if (depth >= std::min(options.max_depth, options.max_recursive_depth)) return _.fail("Maximum nesting depth exceeded");
+                if (options.schema && !options.schema->allows(schema_node, object)) return _.fail("Value does not match the type in the schema");
+                auto _nesting = nest();
+                
+                auto _list = parse_list(
+                    [&] { return parse_member(); }, 
+                    [&](auto&& val) { 
+                        if (spans) { // A duplicate key replaces the earlier member, and its span
+                            auto& _object = _result.value();
+                            auto _duplicate = std::ranges::find(_object, val.first, &object_t::value_type::first);
+                            if (_duplicate != _object.end()) spans->erase(spans->begin() + std::distance(_object.begin(), _duplicate));
+                        }
+
+                        add_member(_result.value(), std::move(val)); 
+                        count_allocation(object, sizeof(typename object_t::value_type) + 2 * sizeof(void*)); // List node
+                    }
+                );
+
+                if (_list.fatal()) return _.fail().merge_errors(_list);
+                if (!_result.value().empty()) {
+                    _result.merge_errors(_list);
+                }
+
+                if (auto _ignored = removeIgnored()) {
+                    return std::move(_ignored).merge_errors(_result);
+                }
+
+                if (startedWithBrace && !consume("}")) {
+                    return _.fail("Expected '}' to close Object")
+                            .merge_errors(_result);
+                }
+
+                count_node(object);
+                return _result;
+            }
+
+            // ------------------------------------------------
+
+            parse_result<array_t> parse_array(bool rootValue) {
+                count(production::array);
+                auto _ = backup();
+                parse_result<array_t> _result = array_t{};
+
+                if (auto _ignored = removeIgnored()) return _ignored;
+
+                bool startedWithBrace = true;
+                if (!consume("[")) {
+                    if (rootValue) {
+                        startedWithBrace = false;
+                    } else {
+                        return _.revert("Expected '[' to begin Array");
+                    }
+                }
+
+                if (depth >= std::min(options.max_depth, options.max_recursive_depth)) return _.fail("Maximum nesting depth exceeded");
+                // Without brackets this might turn out not to be an array, so only check the type once parsed
+                if (startedWithBrace && options.schema && !options.schema->allows(schema_node, array)) return _.fail("Value does not match the type in the schema");
+                auto _nesting = nest();
+                _result.value() = new_array();
+
+                auto _elements = backup();
+                auto _parse_elements = [&](std::size_t node) {
+                    std::size_t _arrayNode = std::exchange(schema_node, node);
+                    auto _list = parse_list(
+                        [&] { return parse_value(false); }, 
+                        [&](auto&& val) { 
+                            auto& _array = _result.value();
+                            std::size_t _capacity = _array.capacity();
+                            _array.push_back(std::move(val)); 
+                            if (_array.capacity() != _capacity) count_allocation(array, _array.capacity() * sizeof(basic_json));
+                        }
+                    );
+                    schema_node = _arrayNode;
+                    return _list;
+                };
+
+                // Without brackets the elements are only checked against the schema once this is 
+                // known to be an array, as a single value is checked as the value itself
+                bool _checkElements = options.schema && startedWithBrace;
+                auto _list = _parse_elements(_checkElements ? options.schema->items(schema_node) : schema::any);
+                if (_list.fatal()) return _.fail().merge_errors(_list);
+
+                // A single value is not a root array without brackets, but the value itself
+                if (!startedWithBrace && _result.value().size() < 2) return _.revert("Expected '[' to begin Array");
+                if (!startedWithBrace && options.schema) {
+                    if (!options.schema->allows(schema_node, array)) return _.fail("Value does not match the type in the schema");
+                    _elements.do_revert(); // Parse the elements again, now checking them against the items
+                    _result.value().clear();
+                    if (spans) spans->clear();
+                    _list = _parse_elements(options.schema->items(schema_node));
+                    if (_list.fatal()) return _.fail().merge_errors(_list);
+                }
+
+                if (!_result.value().empty()) {
+                    _result.merge_errors(_list);
+                }
+
+                if (auto _ignored = removeIgnored()) {
+                    return std::move(_ignored).merge_errors(_result);
+                }
+
+                if (startedWithBrace && !consume("]")) {
+                    return _.fail("Expected ']' to close Array")
+                            .merge_errors(_result);
+                }
+
+                count_node(array);
+                return _result;
+            }
+
+            // ------------------------------------------------
+
+            parse_result<basic_json> parse_value_ambiguous() {
+                count(production::ambiguous);
+                auto _ = backup();
+                parse_result<basic_json> _result = basic_json{};
+
+                if (auto _ignored = removeIgnored()) return _ignored;
+
+                if (consume("true")) _result.value() = true;
+                else if (consume("false")) _result.value() = false;
+                else if (consume("null")) _result.value() = nullptr;
+                else if (maybe([&] { return parse_number(); }, _result.value()).has_value());
+                else return _.revert("Not a potentially ambiguous value");
+
+                // Because after a true/false/null/number there could be other characters that
+                // could turn it into a string check whether this really is the parsed type.
+                auto temp = backup(); // backup, because we don't want to actually consume 
+                ignore(whitespace_no_lf);
+                auto _comment = parse_comment();
+                if (_comment.fatal()) return _comment;
+                if (_comment.has_value() || consume_one_of("\n,][}{:") || value.empty()) {
+                    temp.revert();
+                    count_node(_result.value().type());
+                    return _result;
+                }
+
+                return _.revert("Value turned out to be a string");
+            }
+
+            parse_result<basic_json> parse_value(bool failWhenNo = true, bool rootValue = false) {
+                count(production::value);
+                auto _ = backup();
+                source_span _span;
+                auto _spans = spans ? std::exchange(spans, &_span.children) : nullptr;
+                if (_spans) _span.begin = value_begin();
+                auto _result = parse_any_value(failWhenNo, rootValue);
+                if (_spans) spans = _spans;
+                if (options.schema && _result.has_value()) {
+                    // Nested values have already been checked while parsing them
+                    if (auto _violation = options.schema->check(_result.value(), schema_node)) {
+                        _.do_revert(); // Report the start of the value
+                        return fail(*_violation);
+                    }
+                }
+
+                if (_result.has_value()) {
+                    pack(_result.value(), options);
+                    if (_spans) {
+                        _span.end = original.size() - value.size();
+                        _spans->push_back(std::move(_span));
+                    }
+                }
+
+                return _result;
+            }
+
+            parse_result<basic_json> parse_any_value(bool failWhenNo, bool rootValue) {
+                if (auto _object = parse_object(rootValue)) return _object;
+                if (spans) spans->clear(); // Of members parsed before the object failed
+                if (auto _array = parse_array(rootValue)) return _array;
+                if (spans) spans->clear();
+                if (auto _ambig = parse_value_ambiguous()) return _ambig;
+                if (auto _str = parse_multiline_string()) return _str;
+                if (auto _str = parse_json_string()) return _str;
+                if (auto _str = parse_quoteless_string()) return _str;
+                return failWhenNo ? fail("Expected value") : revert();
+            }
+
+            // Strict json, parsed with an explicit stack instead of recursion, so the nesting is only
+            // limited by max_depth, and every level costs an element on the heap instead of a few 
+            // stack frames. Returns nothing at the first thing that is not strict json, the input
+            // is then parsed by the recursive parser, which supports hjson and reports errors, up to
+            // max_recursive_depth.
+            std::optional<parse_result<basic_json>> parse_iterative() {
+                auto _ = backup();
+                [[maybe_unused]] stats_t _stats = stats;
+                auto _fallback = [&] {
+                    _.do_revert();
+                    if constexpr (stats_enabled) stats = _stats; // Counted again by the recursive parser
+                    return std::nullopt;
+                };
+
+                std::vector<basic_json> _containers; // Arrays and objects being parsed, innermost last
+                std::vector<string_t> _keys;         // Key of the member being parsed, per object
+                basic_json _value;                   // Last parsed value
+
+                // Key and ':' of the next member
+                auto _key = [&] {
+                    ignore();
+                    if (!value.starts_with('"')) return false;
+                    auto _string = parse_json_string();
+                    if (!_string.has_value() || !_string._errors.empty() || _string.value().empty()) return false;
+                    _keys.push_back(std::move(_string.value()));
+                    ignore();
+                    if (!consume(":")) return false;
+                    return true;
+                };
+
+                while (true) {
+                    ignore();
+                    if (value.empty()) return _fallback();
+                    char _c = value[0];
+                    if (_c == '[' || _c == '{') {
+                        if (depth + _containers.size() >= options.max_depth) return parse_result<basic_json>{ fail("Maximum nesting depth exceeded") };
+                        consume_first(1);
+#if BASIC_JSON_PARSER_STATS
+                        stats.max_depth = std::max(stats.max_depth, depth + _containers.size() + 1);
+#endif
+                        _containers.push_back(_c == '[' ? basic_json{ new_array() } : basic_json{ object_t{} });
+                        ignore();
+                        if (!consume(_c == '[' ? "]" : "}")) {
+                            if (_c == '{' && !_key()) return _fallback();
+                            continue; // Parse the first element
+                        }
+
+                        _value = std::move(_containers.back());
+                        _containers.pop_back();
+                        count_node(_c == '[' ? array : object);
+                    } else if (_c == '"') {
+                        auto _string = parse_json_string();
+                        if (!_string.has_value() || !_string._errors.empty()) return _fallback();
+                        _value = std::move(_string.value());
+                    } else if (consume("true")) _value = true;
+                    else if (consume("false")) _value = false;
+                    else if (consume("null")) _value = nullptr;
+                    else if (_c == '-' || (_c >= '0' && _c <= '9')) {
+                        auto _number = parse_number();
+                        if (!_number.has_value() || !_number._errors.empty()) return _fallback();
+                        _value = std::move(_number.value());
+                    } else return _fallback();
+
+                    if (_value.is(number) || _value.is(boolean) || _value.is(null)) count_node(_value.type()); // Strings count themselves
+
+                    // Add the value to its container, and close every container that ends after it.
+                    // Anything else after a value, like text after a number, is not strict json.
+                    while (true) {
+                        ignore();
+                        if (_containers.empty()) {
+                            if (!value.empty()) return _fallback();
+                            return parse_result<basic_json>{ std::move(_value) };
+                        }
+
+                        auto& _container = _containers.back();
+                        if (auto _array = std::get_if<array_t>(&_container._value)) {
+                            std::size_t _capacity = _array->capacity();
+                            _array->push_back(std::move(_value));
+                            if (_array->capacity() != _capacity) count_allocation(array, _array->capacity() * sizeof(basic_json));
+                            if (consume(",")) break;
+                            if (!consume("]")) return _fallback();
+                            count_node(array);
+                        } else {
+                            add_member(std::get<object_t>(_container._value), { std::move(_keys.back()), std::move(_value) });
+                            count_allocation(object, sizeof(typename object_t::value_type) + 2 * sizeof(void*)); // List node
+                            _keys.pop_back();
+                            if (consume(",")) {
+                                if (!_key()) return _fallback();
+                                break;
+                            }
+
+                            if (!consume("}")) return _fallback();
+                            count_node(object);
+                        }
+
+                        _value = std::move(_container);
+                        _containers.pop_back();
+                        pack(_value, options);
+                    }
+                }
+            }
+
+            // Root value, must be followed by nothing but whitespace and comments
+            parse_result<basic_json> parse_root() {
+                if (options.threads > 1 && value.size() >= options.parallel_min_size && !options.spans) {
+                    if (auto _parallel = parse_root_parallel()) return std::move(_parallel.value());
+                }
+
+                if (!options.schema && !options.spans) {
+                    if (auto _iterative = parse_iterative()) return std::move(*_iterative);
+                }
+
+                std::vector<source_span> _spans;
+                if (options.spans) spans = &_spans;
+                auto _result = parse_value(true, true);
+                spans = nullptr;
+                if (!_result.has_value()) return _result;
+
+                if (auto _ignored = removeIgnored()) {
+                    return std::move(_ignored).merge_errors(_result);
+                }
+
+                if (!value.empty()) {
+                    return fail("Expected end of input after value")
+                            .merge_errors(_result);
+                }
+
+                if (options.spans) *options.spans = std::move(_spans.front());
+                return _result;
+            }
+
+            // Value that spans all of the input, used to parse part of a document again
+            parse_result<basic_json> parse_exact() {
+                auto _result = parse_value();
+                if (!_result.has_value()) return _result;
+                if (!value.empty()) {
+                    return fail("Expected end of value")
+                            .merge_errors(_result);
+                }
+
+                return _result;
+            }
+
+            // Offset of the next value, past whitespace and comments
+            std::size_t value_begin() {
+                auto _ = backup();
+                removeIgnored();
+                std::size_t _begin = original.size() - value.size();
+                _.do_revert();
+                return _begin;
+            }
+
+            // ------------------------------------------------
+
+            // Whether the value starts with a key followed by ':', for objects without braces
+            bool starts_with_member() {
+                auto _ = backup();
+                if (removeIgnored().fatal()) return _.revert(), false;
+                if (!parse_json_string().has_value() && consume_while_not(",:[]{} \t\n\r\f\v").empty()) {
+                    return _.revert(), false;
+                }
+
+                bool _result = !removeIgnored().fatal() && consume(":");
+                _.revert();
+                return _result;
+            }
+
+            // ------------------------------------------------
+
+            // Parses a root array in parts on multiple threads. Returns nothing when the input can't
+            // be split safely or when any part fails to parse, the sequential parse then produces
+            // the result, including the exact same errors.
+            std::optional<parse_result<basic_json>> parse_root_parallel() {
+                auto _ = backup();
+                if (removeIgnored().fatal() || !value.starts_with('[')) return _.revert(), std::nullopt;
+
+                auto _parts = split_root_array(options.threads);
+                if (_parts.size() < 3) return _.revert(), std::nullopt; // Less than 2 parts
+
+                std::vector<parser> _parsers;
+                std::vector<std::optional<parse_result<array_t>>> _results(_parts.size() - 1);
+                for (std::size_t i = 0; i < _results.size(); ++i) {
+                    _parsers.push_back(for_part(original, _parts[i], options, depth + 1));
+                    if (options.schema) _parsers.back().schema_node = options.schema->items(schema_node);
+                }
+
+                {
+                    std::vector<std::jthread> _workers;
+                    for (std::size_t i = 1; i < _results.size(); ++i) {
+                        _workers.emplace_back([&, i] { _results[i] = _parsers[i].parse_elements(i == _results.size() - 1); });
+                    }
+
+                    _results[0] = _parsers[0].parse_elements(_results.size() == 1);
+                }
+
+                parse_result<array_t> _result = array_t{};
+                std::size_t _size = 0;
+                for (auto& _part : _results) {
+                    if (!_part) return _.revert(), std::nullopt;
+                    _size += _part->value().size();
+                }
+
+                _result.value().reserve(_size);
+                for (std::size_t i = 0; i < _results.size(); ++i) {
+                    auto& _elements = _results[i]->value();
+                    _result.value().insert(_result.value().end(), std::make_move_iterator(_elements.begin()), std::make_move_iterator(_elements.end()));
+                    _result.merge_errors(std::move(*_results[i]));
+#if BASIC_JSON_PARSER_STATS
+                    stats += _parsers[i].stats;
+#endif
+                }
+
+                count_node(array);
+                count_allocation(array, _size * sizeof(basic_json));
+
+                value = _parts.back(); // Everything after the closing ']'
+                if (removeIgnored().fatal() || !value.empty()) return _.revert(), std::nullopt;
+
+                parse_result<basic_json> _json{ std::move(_result) };
+                if (options.schema && options.schema->check(_json.value(), schema_node)) return _.revert(), std::nullopt;
+                pack(_json.value(), options);
+                return _json;
+            }
+
+            // Parses all elements in value, which is a part of a root array
+            std::optional<parse_result<array_t>> parse_elements(bool last) {
+                parse_result<array_t> _result = array_t{};
+                std::string_view _afterLast = value;
+                auto _list = parse_list(
+                    [&] { return parse_value(false); },
+                    [&](auto&& val) { _result.value().push_back(std::move(val)), _afterLast = value; }
+                );
+
+                if (_list.fatal() || removeIgnored().fatal() || !value.empty()) return std::nullopt;
+                if (!last && _result.value().empty()) return std::nullopt; // Only the last part may be empty, after a trailing comma
+
+                // Same for a comma after the last element, in the middle it means 2 consecutive commas
+                parser _trailing{ original, _afterLast };
+                if (!last && (_trailing.removeIgnored().fatal() || _trailing.value.starts_with(','))) return std::nullopt;
+                if (!_result.value().empty()) _result.merge_errors(_list);
+                return _result;
+            }
+
+            // Finds the elements of a root array without parsing them. Can be resumed when more input 
+            // arrives. Gives up on anything that could make the structure ambiguous without parsing, 
+            // like quoteless strings, multi-line strings, or literals not followed by a value terminator.
+            struct structure_scanner {
+
+                // ------------------------------------------------
+
+                enum class state { value, string, escape, line_comment, block_comment, done, ambiguous };
+
+                // ------------------------------------------------
+
+                state current = state::value;
+                char quote = 0;
+                std::size_t level = 0;
+                std::size_t position = 0;                       // Next character to scan
+                std::size_t begin = std::string_view::npos;     // First character after the opening '['
+                std::size_t end = std::string_view::npos;       // Closing ']'
+
+                // ------------------------------------------------
+
+                bool done() const { return current == state::done; }
+                bool ambiguous() const { return current == state::ambiguous; }
+
+                // Scans text from position, and calls separator with the index of every comma between 
+                // elements of the root array. Unless final, stops before a token that's cut off by the 
+                // end of text, so the scan can be resumed once text has grown.
+                template<class Separator>
+                void scan(std::string_view text, bool final, Separator&& separator) {
+                    auto incomplete = [&](std::size_t i) { return !final && i >= text.size(); };
+
+                    for (std::size_t& i = position; i < text.size(); ++i) {
+                        char c = text[i];
+                        switch (current) {
+                        case state::done: case state::ambiguous: return;
+                        case state::escape: current = state::string; continue;
+                        case state::string: 
+                            if (c == '\\') current = state::escape;
+                            else if (c == quote) current = state::value;
+                            continue;
+                        case state::line_comment: 
+                            if (c == '\n') current = state::value;
+                            continue;
+                        case state::block_comment:
+                            if (c != '*') continue;
+                            if (incomplete(i + 1)) return;
+                            if (i + 1 < text.size() && text[i + 1] == '/') ++i, current = state::value;
+                            continue;
+                        case state::value: break;
+                        }
+
+                        switch (c) {
+                        case '"': case '\'':
+                            if (c == '\'' && incomplete(i + 2)) return;
+                            if (text.substr(i).starts_with("\'\'\'")) { current = state::ambiguous; return; } // Multi-line string
+                            current = state::string, quote = c;
+                            break;
+                        case '#':
+                            current = state::line_comment;
+                            break;
+                        case '/':
+                            if (incomplete(i + 1)) return;
+                            if (text.substr(i).starts_with("//")) current = state::line_comment, ++i;
+                            else if (text.substr(i).starts_with("/*")) current = state::block_comment, ++i;
+                            else { current = state::ambiguous; return; }
+                            break;
+                        case '[': case '{':
+                            if (level == 0 && c == '{') { current = state::ambiguous; return; } // Not an array
+                            if (level++ == 0) begin = i + 1;
+                            break;
+                        case ']': case '}':
+                            if (level == 0 || (--level == 0 && c != ']')) { current = state::ambiguous; return; }
+                            if (level == 0) {
+                                end = i++, current = state::done;
+                                return;
+                            }
+                            break;
+                        case ',':
+                            if (level == 0) { current = state::ambiguous; return; }
+                            if (level == 1) separator(i);
+                            break;
+                        case ':': case ' ': case '\t': case '\n': case '\r': case '\f': case '\v':
+                            break;
+                        default: {
+                            // Literal or number, must be followed by something that ends it, exactly 
+                            // like in parse_value_ambiguous, otherwise it might be a quoteless string
+                            std::size_t _end = std::min(text.find_first_of(",:[]{} \t\n\r\f\v", i), text.size());
+                            std::size_t _next = std::min(text.find_first_not_of(whitespace_no_lf, _end), text.size());
+                            if (incomplete(_next + 1)) return; // Need the word and the character after it
+                            auto _word = text.substr(i, _end - i);
+                            auto _rest = text.substr(_next);
+                            if (level == 0 || (_word != "true" && _word != "false" && _word != "null" && !is_json_number(_word)) 
+                                || (!_rest.empty() && !one_of(_rest[0], "\n,][}{:#") && !_rest.starts_with("//") && !_rest.starts_with("/*"))) 
+                            {
+                                current = state::ambiguous;
+                                return;
+                            }
+                            i = _end - 1;
+                            break;
+                        }
+                        }
+                    }
+
+                    if (final && current != state::done) current = state::ambiguous;
+                }
+
+                // ------------------------------------------------
+
+            };
+
+            // Splits the root array at value in about parts equally sized parts at commas that separate
+            // its elements. The last view is what comes after the closing ']'. Empty when the structure
+            // of the array can't be determined without parsing.
+            std::vector<std::string_view> split_root_array(std::size_t parts) const {
+                std::vector<std::size_t> _commas;
+                std::size_t _partSize = value.size() / parts + 1;
+                structure_scanner _scanner;
+                _scanner.scan(value, true, [&](std::size_t i) {
+                    if (i >= _partSize * (_commas.size() + 1) && _commas.size() + 1 < parts) _commas.push_back(i);
+                });
+
+                if (!_scanner.done()) return {};
 
-            };
+                std::vector<std::string_view> _result;
+                std::size_t _start = _scanner.begin;
+                for (std::size_t _comma : _commas) {
+                    _result.push_back(value.substr(_start, _comma - _start));
+                    _start = _comma + 1;
+                }
 
-            struct error {
-                std::size_t line = 0;
-                std::size_t character = 0;
-                error_message message;
+                _result.push_back(value.substr(_start, _scanner.end - _start));
+                _result.push_back(value.substr(_scanner.end + 1));
+                return _result;
+            }
 
-                std::string what() const {
-                    return std::format("line {}, character {}: {}", line, character, message.message);
+            constexpr static bool is_json_number(std::string_view str) {
+                auto digits = [&] {
+                    std::size_t _count = 0;
+                    while (!str.empty() && str[0] >= '0' && str[0] <= '9') str.remove_prefix(1), ++_count;
+                    return _count;
+                };
+
+                if (str.starts_with('-')) str.remove_prefix(1);
+                if (str.starts_with('0')) str.remove_prefix(1);
+                else if (digits() == 0) return false;
+                if (str.starts_with('.') && (str.remove_prefix(1), digits() == 0)) return false;
+                if (str.starts_with('e') || str.starts_with('E')) {
+                    str.remove_prefix(1);
+                    if (str.starts_with('+') || str.starts_with('-')) str.remove_prefix(1);
+                    if (digits() == 0) return false;
                 }
-            };
 
-            struct error_result {
+                return str.empty();
+            }
 
-                // ------------------------------------------------
+            // ------------------------------------------------
 
-                std::string_view parsed_until;
-                error_message message;
+        };
 
-                // ------------------------------------------------
+        // ------------------------------------------------
+        
+        static parser::result<basic_json> parse(std::string_view json) { return parse(json, parser::parse_options{}); }
+        static parser::result<basic_json> parse(std::string_view json, parser::parse_options options) {
+            parser _parser{ json, json, options };
+            parser::result<basic_json> _result = _parser.parse_root();
+            _result._stats = _parser.stats;
+            return _result;
+        }
 
-                operator error() const {
-                    std::size_t newlines = 1;
-                    std::size_t charsInLine = 1;
-                    for (auto& c : parsed_until) {
-                        ++charsInLine;
-                        if (c == '\n') ++newlines, charsInLine = 1;
+        // Parses into target, reusing the strings, arrays and object members it holds for the new
+        // document, so repeatedly parsing similarly shaped documents hardly allocates. Whatever the 
+        // new document does not reuse is freed. On failure target is null.
+        static parser::result<basic_json*> parse_into(basic_json& target, std::string_view json) { return parse_into(target, json, parser::parse_options{}); }
+        static parser::result<basic_json*> parse_into(basic_json& target, std::string_view json, parser::parse_options options) {
+            thread_local parser::recycler _recycler; // Keeps the capacity of its own vectors between calls
+            _recycler.collect(target);
+
+            parser _parser{ json, json, options };
+            _parser.recycle = &_recycler;
+            auto _parsed = _parser.parse_root();
+            _recycler.clear();
+
+            parser::result<basic_json*> _result = parser::parse_result<>{ ._errors = std::move(_parsed._errors), ._state = _parsed._state };
+            if (_parsed.has_value()) {
+                target = std::move(_parsed.value());
+                _result._value = &target;
+            }
+
+            _result._stats = _parser.stats;
+            return _result;
+        }
+
+        // Change to a source text, removed bytes at offset are replaced by inserted
+        struct text_edit {
+            std::size_t offset = 0;
+            std::size_t removed = 0;
+            std::string_view inserted;
+        };
+
+        // Updates a document and the spans recorded while parsing it (parse_options::spans) after
+        // an edit to its source, text is the source after the edit. Only the innermost array, object
+        // or json string that encloses the edit is parsed again, the rest of the document is kept, 
+        // and the spans after the edit are moved. When that part doesn't parse as one value on its
+        // own, the whole text is parsed again. Returns the value that was parsed again. On failure 
+        // the document and spans are left as they were.
+        static parser::result<basic_json*> reparse(basic_json& document, parser::source_span& spans, std::string_view text, text_edit edit) { return reparse(document, spans, text, edit, parser::parse_options{}); }
+        static parser::result<basic_json*> reparse(basic_json& document, parser::source_span& spans, std::string_view text, text_edit edit, parser::parse_options options) {
+            using source_span = parser::source_span;
+            std::size_t _editEnd = edit.offset + edit.removed;
+            std::size_t _delta = edit.inserted.size() - edit.removed; // Wraps around when the text got shorter
+
+            // Innermost value that strictly contains the edit, and starts and ends with a delimiter
+            std::vector<source_span*> _path{ &spans };
+            basic_json* _node = &document;
+            std::size_t _schemaNode = 0;
+            while (true) {
+                auto& _children = _path.back()->children;
+                auto _child = std::ranges::find_if(_children, [&](const source_span& span) {
+                    return span.begin < edit.offset && _editEnd < span.end;
+                });
+
+                if (_child == _children.end() || !one_of(text[_child->begin], "[{\"")) break;
+                std::size_t _index = static_cast<std::size_t>(_child - _children.begin());
+                if (_index >= _node->size()) break; // Spans don't match the document
+
+                if (_node->is(array)) {
+                    if (options.schema) _schemaNode = options.schema->items(_schemaNode);
+                    _node = &(*_node)[_index];
+                } else if (_node->is(object)) {
+                    auto& _member = *std::next(_node->as<object_t>().begin(), _index);
+                    if (options.schema) {
+                        auto _property = options.schema->property(_schemaNode, _member.first);
+                        if (!_property) break;
+                        _schemaNode = *_property;
                     }
+                    _node = &_member.second;
+                } else break;
 
-                    return {
-                        .line = newlines,
-                        .character = charsInLine,
-                        .message = message,
+                _path.push_back(&*_child);
+            }
+
+            parser::result<basic_json*> _result = parser::parse_result<>{ ._state = parser::parse_result_state::recoverable };
+            if (_path.size() > 1) {
+                source_span& _target = *_path.back();
+                std::string_view _part = text.substr(_target.begin, _target.end - _target.begin + _delta);
+                std::vector<source_span> _spans;
+                parser _parser = parser::for_part(text, _part, options, _path.size() - 1);
+                _parser.spans = &_spans;
+                _parser.schema_node = _schemaNode;
+                auto _parsed = _parser.parse_exact();
+                _result._stats = _parser.stats;
+                if (_parsed.has_value()) {
+                    *_node = std::move(_parsed.value());
+                    _target = std::move(_spans.front());
+
+                    // Everything after the target moves along with the end of the edit
+                    auto _shift = [&](this auto& self, source_span& span) -> void {
+                        span.begin += _delta, span.end += _delta;
+                        for (auto& _child : span.children) self(_child);
                     };
+
+                    for (std::size_t i = 0; i + 1 < _path.size(); ++i) {
+                        _path[i]->end += _delta;
+                        auto& _children = _path[i]->children;
+                        auto _next = _children.begin() + (_path[i + 1] - _children.data()) + 1;
+                        std::for_each(_next, _children.end(), _shift);
+                    }
+
+                    _result.append_errors(_parsed._errors);
+                    _result._value = _node;
+                    return _result;
                 }
+            }
 
-                // ------------------------------------------------
+            source_span _spans;
+            options.spans = &_spans;
+            parser _parser{ text, text, options };
+            auto _parsed = _parser.parse_root();
+            _result = parser::parse_result<>{ ._errors = std::move(_parsed._errors), ._state = _parsed._state };
+            _result._stats = _parser.stats;
+            if (_parsed.has_value()) {
+                document = std::move(_parsed.value());
+                spans = std::move(_spans);
+                _result._value = &document;
+            }
 
-            };
+            return _result;
+        }
+
+        // ------------------------------------------------
+
+        // Parses a document that arrives in pieces. The elements of a root array are parsed as 
+        // soon as they are complete, so the work is spread over the calls to feed. Anything else
+        // is parsed by finish. The result is identical to parsing the whole input at once.
+        class incremental_parser {
+        public:
+            incremental_parser() = default;
+            explicit incremental_parser(parser::parse_options options) : _options(options) {}
+
+            void feed(std::string_view data) {
+                _buffer += data;
+                if (_fallback) return;
+
+                std::size_t _last = std::string_view::npos;
+                _scanner.scan(_buffer, false, [&](std::size_t comma) { _last = comma; });
+                if (_scanner.ambiguous()) _fallback = true;
+                else if (_last != std::string_view::npos) parse_elements(_last, false);
+            }
+
+            parser::result<basic_json> finish() {
+                if (!_fallback) _scanner.scan(_buffer, true, [](std::size_t) {});
+                if (!_fallback && _scanner.done()) {
+                    parse_elements(_scanner.end, true);
+
+                    parser _rest{ _buffer, std::string_view{ _buffer }.substr(_scanner.end + 1), _options };
+                    basic_json _array = std::move(_elements);
+                    if (_options.schema && _options.schema->check(_array, 0)) _fallback = true;
+                    parser::pack(_array, _options);
+                    if (!_fallback && !_rest.removeIgnored().fatal() && _rest.value.empty()) {
+                        parser::result<basic_json> _result = std::move(_array);
+                        _result._errors = std::move(_errors);
+                        return _result;
+                    }
+                }
+
+                return parse(_buffer, _options);
+            }
+
+        private:
+            parser::parse_options _options{};
+            std::string _buffer;
+            parser::structure_scanner _scanner;
+            array_t _elements;
+            std::vector<parser::error> _errors;
+            std::size_t _start = std::string_view::npos; // Start of the elements that are not yet parsed
+            bool _fallback = false;                      // Parse everything at once in finish
+
+            // Parses the elements up to until, which is a separating comma or the closing ']'
+            void parse_elements(std::size_t until, bool last) {
+                if (_start == std::string_view::npos) {
+                    // Comments in front of the opening '[' are only scanned, not parsed
+                    _start = _scanner.begin;
+                    if (_options.validate_utf8 && !validate_utf8(std::string_view{ _buffer }.substr(0, _start))) {
+                        _fallback = true;
+                        return;
+                    }
+                }
+
+                std::string_view _text = std::string_view{ _buffer }.substr(_start, until - _start);
+                _start = until + 1;
+
+                parser _parser = parser::for_part(_buffer, _text, _options, 1);
+                if (_options.schema) _parser.schema_node = _options.schema->items(0);
+                auto _parsed = _parser.parse_elements(last);
+                if (!_parsed) {
+                    _fallback = true;
+                    return;
+                }
+
+                parser::result<array_t> _result = std::move(*_parsed);
+                _elements.insert(_elements.end(), std::make_move_iterator(_result.value().begin()), std::make_move_iterator(_result.value().end()));
+                _errors.insert(_errors.end(), _result._errors.begin(), _result._errors.end());
+            }
+        };
+
+        // Parses the input read from source, without blocking while waiting for more input. 
+        // co_await source.read() must give the next piece of input, or nothing when it ended.
+        template<class Source>
+        static task<parser::result<basic_json>> parse_async(Source& source) { return parse_async(source, parser::parse_options{}); }
+        template<class Source>
+        static task<parser::result<basic_json>> parse_async(Source& source, parser::parse_options options) {
+            incremental_parser _parser{ options };
+            while (true) {
+                std::string_view _data = co_await source.read();
+                if (_data.empty()) break;
+                _parser.feed(_data);
+            }
+
+            co_return _parser.finish();
+        }
+
+        // ------------------------------------------------
+
+        // JSON Schema validator, compiled from a subset of draft 2020-12: type, enum, const, minimum,
+        // maximum, exclusiveMinimum, exclusiveMaximum, minLength, maxLength, minItems, maxItems, 
+        // required, properties, additionalProperties and items. Other keywords are ignored. Never
+        // changes once compiled, so it can be used by multiple threads and parses at once. Pass it 
+        // in parser::parse_options to validate while parsing.
+        class schema {
+        public:
+            using node_index = std::size_t;
+            constexpr static node_index any = static_cast<node_index>(-1); // Accepts everything
 
             // ------------------------------------------------
 
-            template<class Ty = void> struct parse_result;
-            template<class Ty = void> 
-            struct result {
-                std::vector<error> _errors;
-                std::optional<Ty> _value;
+            explicit schema(const basic_json& definition) { compile(definition); }
 
-                result(error_message msg)
-                    : _errors{ error{.message = msg } }
-                {}
-                
-                result(Ty&& result)
-                    : _value(std::move(result))
-                {}
+            // ------------------------------------------------
 
-                template<class T> requires (!std::same_as<Ty, void> && std::constructible_from<Ty, T>)
-                result(T&& result)
-                    : _value(std::move(result))
-                {}
+            // Message of the first violation, or nothing when the value is valid
+            std::optional<std::string_view> violation(const basic_json& value) const { return violation(value, 0); }
+            bool matches(const basic_json& value) const { return !violation(value); }
 
-                template<class T> requires (!std::same_as<Ty, void> && std::constructible_from<Ty, T>)
-                result(parse_result<T>&& result)
-                    : _errors(result._errors.begin(), result._errors.end())
-                    , _value(std::move(result._value))
-                {}
-                
-                result(parse_result<void>&& result)
-                    : _errors(result._errors.begin(), result._errors.end())
-                {}
+            // ------------------------------------------------
 
-                const std::vector<error>& errors() const { return _errors; }
-                explicit operator bool() const { return _value.has_value(); }
-                bool has_value() const { return _value.has_value(); }
-                Ty& value() { return _value.value(); }
+            // Checks the constraints of the node on the value itself, not on its elements or members
+            std::optional<parser::error_message> check(const basic_json& value, node_index index) const {
+                if (index == any) return std::nullopt;
+                auto& node = _nodes[index];
+                if (!allows(index, value)) return "Value does not match the type in the schema";
+                if (!node.enumeration.empty() && std::ranges::find(node.enumeration, value) == node.enumeration.end()) {
+                    return "Value is not one of the values allowed by the schema";
+                }
 
-                Ty* operator->() { return &_value.value(); }
+                switch (value.type()) {
+                case number: {
+                    double val = value.as<double>();
+                    if ((node.minimum && val < *node.minimum) || (node.maximum && val > *node.maximum)
+                        || (node.exclusive_minimum && val <= *node.exclusive_minimum) 
+                        || (node.exclusive_maximum && val >= *node.exclusive_maximum)) {
+                        return "Number is out of the range allowed by the schema";
+                    }
+                    break;
+                }
+                case string: {
+                    auto& str = value.as<string_t>();
+                    std::size_t codepoints = std::ranges::count_if(str, [](char c) { return (c & 0xC0) != 0x80; });
+                    if (codepoints < node.min_size || codepoints > node.max_size) return "String length is out of the range allowed by the schema";
+                    break;
+                }
+                case array:
+                    if (value.size() < node.min_size || value.size() > node.max_size) return "Array size is out of the range allowed by the schema";
+                    break;
+                case object:
+                    for (auto& key : node.required) {
+                        if (!value.contains(key)) return "Object is missing a property required by the schema";
+                    }
+                    break;
+                default: break;
+                }
+
+                return std::nullopt;
+            }
+
+            // Node for the member with key of an object matching node index, nothing when not allowed
+            std::optional<node_index> property(node_index index, std::string_view key) const {
+                if (index == any) return any;
+                auto& node = _nodes[index];
+                auto it = std::ranges::lower_bound(node.properties, key, {}, &std::pair<std::string, node_index>::first);
+                if (it != node.properties.end() && it->first == key) return it->second;
+                if (node.additional == none) return std::nullopt;
+                return node.additional;
+            }
+
+            // Node for the elements of an array matching node index
+            node_index items(node_index index) const { return index == any ? any : _nodes[index].items; }
+
+            bool allows(node_index index, type_index type) const { 
+                return index == any || (_nodes[index].types & (1u << type)) || (type == number && (_nodes[index].types & integer_bit));
+            }
+
+            bool allows(node_index index, const basic_json& value) const {
+                if (index == any) return true;
+                auto types = _nodes[index].types;
+                if (types & (1u << value.type())) return true;
+                return value.is(number) && (types & integer_bit) && _is_integer(value);
+            }
+
+            // ------------------------------------------------
+
+        private:
+            constexpr static node_index none = any - 1; // additionalProperties: false
+            constexpr static std::uint8_t integer_bit = 1u << undefined;
+            constexpr static std::uint8_t all_types = (1u << undefined) - 1;
+
+            struct node {
+                std::uint8_t types = all_types; // Bit per type_index, and integer_bit
+                std::vector<basic_json> enumeration;
+                std::optional<double> minimum;
+                std::optional<double> maximum;
+                std::optional<double> exclusive_minimum;
+                std::optional<double> exclusive_maximum;
+                std::size_t min_size = 0; // Code points of strings, elements of arrays
+                std::size_t max_size = static_cast<std::size_t>(-1);
+                std::vector<std::string> required;
+                std::vector<std::pair<std::string, node_index>> properties; // Sorted by key
+                node_index additional = any;
+                node_index items = any;
             };
 
+            std::vector<node> _nodes; // Root at index 0
+
             // ------------------------------------------------
-            
-            enum class parse_result_state {
-                success,     // Parsed successfully 
-                recoverable, // Failed to parse, but continue
-                fatal,       // Fatal parse error, non-recoverable
+
+            node_index compile(const basic_json& definition) {
+                node_index index = _nodes.size();
+                _nodes.emplace_back();
+
+                node result;
+                if (definition.is(boolean)) {
+                    result.types = definition.as<boolean_t>() ? all_types : 0;
+                } else if (definition.is(object)) {
+                    auto to_size = [](const basic_json& val) {
+                        if (!val.is(number) || val.as<double>() < 0) throw std::runtime_error("Invalid schema.");
+                        return val.as<std::size_t>();
+                    };
+
+                    auto to_number = [](const basic_json& val) {
+                        if (!val.is(number)) throw std::runtime_error("Invalid schema.");
+                        return val.as<double>();
+                    };
+
+                    for (auto& [key, val] : definition.as<object_t>()) {
+                        if (key == "type") result.types = types_of(val);
+                        else if (key == "enum") {
+                            if (!val.is(array)) throw std::runtime_error("Invalid schema.");
+                            result.enumeration = val.as<array_t>();
+                        } else if (key == "const") result.enumeration = { val };
+                        else if (key == "minimum") result.minimum = to_number(val);
+                        else if (key == "maximum") result.maximum = to_number(val);
+                        else if (key == "exclusiveMinimum") result.exclusive_minimum = to_number(val);
+                        else if (key == "exclusiveMaximum") result.exclusive_maximum = to_number(val);
+                        else if (key == "minLength" || key == "minItems") result.min_size = to_size(val);
+                        else if (key == "maxLength" || key == "maxItems") result.max_size = to_size(val);
+                        else if (key == "items") result.items = compile(val);
+                        else if (key == "additionalProperties") {
+                            result.additional = val.is(boolean) && !val.as<boolean_t>() ? none : compile(val);
+                        } else if (key == "required") {
+                            if (!val.is(array)) throw std::runtime_error("Invalid schema.");
+                            for (auto& required : val.as<array_t>()) {
+                                if (!required.is(string)) throw std::runtime_error("Invalid schema.");
+                                result.required.push_back(required.as<string_t>());
+                            }
+                        } else if (key == "properties") {
+                            if (!val.is(object)) throw std::runtime_error("Invalid schema.");
+                            for (auto& [name, property] : val.as<object_t>()) result.properties.emplace_back(name, compile(property));
+                            std::ranges::sort(result.properties, {}, &std::pair<std::string, node_index>::first);
+                        }
+                    }
+                } else {
+                    throw std::runtime_error("Invalid schema.");
+                }
+
+                _nodes[index] = std::move(result); // Not a reference, compiling nested schemas grows _nodes
+                return index;
+            }
+
+            static std::uint8_t types_of(const basic_json& type) {
+                if (type.is(array)) {
+                    std::uint8_t result = 0;
+                    for (auto& element : type.as<array_t>()) result |= types_of(element);
+                    return result;
+                }
+
+                if (!type.is(string)) throw std::runtime_error("Invalid schema.");
+                auto& name = type.as<string_t>();
+                if (name == "null") return 1u << null;
+                if (name == "boolean") return 1u << boolean;
+                if (name == "object") return 1u << object;
+                if (name == "array") return 1u << array;
+                if (name == "number") return 1u << number;
+                if (name == "string") return 1u << string;
+                if (name == "integer") return integer_bit;
+                throw std::runtime_error("Invalid schema.");
+            }
+
+            static bool _is_integer(const basic_json& value) {
+                return std::visit([](auto val) { 
+                    if constexpr (std::floating_point<decltype(val)>) return val == std::trunc(val); 
+                    else return true;
+                }, value._number());
+            }
+
+            std::optional<std::string_view> violation(const basic_json& value, node_index index) const {
+                if (auto message = check(value, index)) return message->message;
+                if (index == any) return std::nullopt;
+
+                if (value.is(array)) {
+                    for (auto& element : value.as<array_t>()) {
+                        if (auto message = violation(element, items(index))) return message;
+                    }
+                } else if (value.is(object)) {
+                    for (auto& [key, member] : value.as<object_t>()) {
+                        auto member_index = property(index, key);
+                        if (!member_index) return "Property is not allowed by the schema";
+                        if (auto message = violation(member, *member_index)) return message;
+                    }
+                }
+
+                return std::nullopt;
+            }
+        };
+
+        // ------------------------------------------------
+
+        // Strict JSON (RFC 8259) parser that can run at compile time. Instead of building a 
+        // basic_json, which can't outlive constant evaluation, it writes a flat list of tokens 
+        // with strings already decoded and integers converted. The _json literal uses this to
+        // report syntax errors as compile errors, and builds the document from the tokens.
+        struct literal_parser {
+
+            // ------------------------------------------------
+
+            enum class kind : std::uint8_t { object, array, string, unsigned_number, signed_number, floating_number, boolean, null };
+
+            // Objects are followed by a string and a value per member, arrays by their elements.
+            struct token {
+                kind type = kind::null;
+                std::size_t size = 0;      // Members or elements
+                std::uint64_t integer = 0; // Integer, or 1 for true
+                std::size_t offset = 0;    // Decoded string, or the null-terminated text of a floating point number, in chars
+                std::size_t length = 0;
             };
 
-            template<class Ty>
-            struct parse_result {
-                std::vector<error_result> _errors;
-                std::optional<Ty> _value;
-                parse_result_state _state;
+            struct result {
+                std::size_t tokens = 0;
+                std::size_t chars = 0;
+                std::size_t position = 0; // Of the error
+                std::optional<parser::error_message> error;
+            };
 
-                parse_result(Ty&& result)
-                    : _value(std::move(result))
-                    , _state(parse_result_state::success)
-                {}
-                
-                template<class T> requires (!std::same_as<T, void> && std::constructible_from<Ty, T>)
-                parse_result(parse_result<T>&& result)
-                    : _errors(std::move(result._errors))
-                    , _value(result.has_value() ? std::optional{ Ty{ std::move(result._value.value()) } } : std::nullopt)
-                    , _state(std::move(result._state))
-                {}
-                
-                parse_result(parse_result<void>&& result)
-                    : _errors(std::move(result._errors))
-                    , _state(std::move(result._state))
-                {}
+            constexpr static std::size_t max_depth = 256;
 
-                bool has_value() const { return _value.has_value(); }
-                Ty& value() { return _value.value(); }
+            // ------------------------------------------------
 
-                template<class T, class Self>
-                Self&& merge_errors(this Self&& self, parse_result<T>&& other) {
-                    self._errors.append_range(std::move(other._errors));
-                    return std::forward<Self>(self);
+            std::string_view text;
+            token* tokens = nullptr; // Only counts tokens and chars when null
+            char* chars = nullptr;
+            std::size_t index = 0;
+            result state{};
+
+            // ------------------------------------------------
+
+            constexpr static result parse(std::string_view text, token* tokens = nullptr, char* chars = nullptr) {
+                literal_parser _parser{ text, tokens, chars };
+                _parser.ignore_whitespace();
+                _parser.parse_value(0);
+                _parser.ignore_whitespace();
+                if (!_parser.state.error && _parser.index != text.size()) _parser.fail("Expected end of input after value");
+                return _parser.state;
+            }
+
+            // Builds the document from parsed tokens
+            static basic_json build(const token* tokens, const char* chars) {
+                std::size_t index = 0;
+                return build(tokens, chars, index);
+            }
+
+            // ------------------------------------------------
+
+        private:
+            constexpr bool fail(parser::error_message message) {
+                if (!state.error) state.error = message, state.position = index;
+                return false;
+            }
+
+            constexpr bool at_end() const { return state.error || index == text.size(); }
+            constexpr bool consume(char c) { return !at_end() && text[index] == c && (++index, true); }
+            constexpr bool consume(std::string_view word) { return !state.error && text.substr(index).starts_with(word) && (index += word.size(), true); }
+            constexpr static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+            constexpr void ignore_whitespace() {
+                while (!at_end() && one_of(text[index], " \t\n\r")) ++index;
+            }
+
+            constexpr std::size_t add(token value) {
+                if (tokens) tokens[state.tokens] = value;
+                return state.tokens++;
+            }
+
+            constexpr void add(char c) {
+                if (chars) chars[state.chars] = c;
+                ++state.chars;
+            }
+
+            // ------------------------------------------------
+
+            constexpr bool parse_value(std::size_t depth) {
+                if (depth == max_depth) return fail("Maximum nesting depth exceeded");
+                if (at_end()) return fail("Expected value");
+                switch (text[index]) {
+                case '{': return parse_container(depth, kind::object, '}');
+                case '[': return parse_container(depth, kind::array, ']');
+                case '"': return parse_string();
+                case 't': return consume("true") ? (add({ .type = kind::boolean, .integer = 1 }), true) : fail("Expected value");
+                case 'f': return consume("false") ? (add({ .type = kind::boolean }), true) : fail("Expected value");
+                case 'n': return consume("null") ? (add({ .type = kind::null }), true) : fail("Expected value");
+                default: return parse_number();
                 }
-                
-                template<class T, class Self>
-                Self&& merge_errors(this Self&& self, const parse_result<T>& other) {
-                    self._errors.append_range(other._errors);
-                    return std::forward<Self>(self);
+            }
+
+            constexpr bool parse_container(std::size_t depth, kind type, char close) {
+                ++index; // Opening brace
+                std::size_t _token = add({ .type = type });
+                std::size_t _size = 0;
+                ignore_whitespace();
+                if (!consume(close)) {
+                    do {
+                        ignore_whitespace();
+                        if (type == kind::object) {
+                            if (at_end() || text[index] != '"') return fail("Expected key");
+                            if (!parse_string()) return false;
+                            ignore_whitespace();
+                            if (!consume(':')) return fail("Expected ':' after key");
+                            ignore_whitespace();
+                        }
+
+                        if (!parse_value(depth + 1)) return false;
+                        ignore_whitespace();
+                        ++_size;
+                    } while (consume(','));
+
+                    if (!consume(close)) return type == kind::object ? fail("Expected '}' to close Object") : fail("Expected ']' to close Array");
                 }
 
-                bool fatal() const { return _state == parse_result_state::fatal; }
-                bool recoverable() const { return _state == parse_result_state::recoverable; }
-                bool success() const { return _state == parse_result_state::success; }
+                if (tokens) tokens[_token].size = _size;
+                return true;
+            }
+
+            constexpr std::optional<char32_t> parse_hex4() {
+                char32_t _result = 0;
+                for (std::size_t i = 0; i < 4; ++i, ++index) {
+                    if (at_end()) return std::nullopt;
+                    char c = text[index];
+                    if (is_digit(c)) _result = _result * 16 + (c - '0');
+                    else if (c >= 'a' && c <= 'f') _result = _result * 16 + (c - 'a' + 10);
+                    else if (c >= 'A' && c <= 'F') _result = _result * 16 + (c - 'A' + 10);
+                    else return std::nullopt;
+                }
+                return _result;
+            }
+
+            constexpr bool parse_string() {
+                ++index; // Opening quote
+                std::size_t _offset = state.chars;
+                while (true) {
+                    if (at_end()) return fail("Expected \" to end json string");
+                    char c = text[index++];
+                    if (c == '"') break;
+                    if (static_cast<unsigned char>(c) < 0x20) return fail("Control character in json string");
+                    if (c != '\\') {
+                        add(c);
+                        continue;
+                    }
+
+                    if (at_end()) return fail("Expected \" to end json string");
+                    switch (text[index++]) {
+                    case '"': add('"'); break;
+                    case '\\': add('\\'); break;
+                    case '/': add('/'); break;
+                    case 'b': add('\b'); break;
+                    case 'f': add('\f'); break;
+                    case 'n': add('\n'); break;
+                    case 'r': add('\r'); break;
+                    case 't': add('\t'); break;
+                    case 'u': {
+                        auto _unit = parse_hex4();
+                        if (!_unit) return fail("Expected 4 hexadecimal digits after \\u");
+                        char32_t _codepoint = *_unit;
+                        if (_codepoint >= 0xD800 && _codepoint <= 0xDBFF) {
+                            if (!consume("\\u")) return fail("Unpaired surrogate in \\u escape");
+                            auto _low = parse_hex4();
+                            if (!_low || *_low < 0xDC00 || *_low > 0xDFFF) return fail("Unpaired surrogate in \\u escape");
+                            _codepoint = 0x10000 + ((_codepoint - 0xD800) << 10) + (*_low - 0xDC00);
+                        } else if (_codepoint >= 0xDC00 && _codepoint <= 0xDFFF) {
+                            return fail("Unpaired surrogate in \\u escape");
+                        }
+
+                        // UTF-8 encode, _utf8_encode appends to a std::string
+                        if (_codepoint < 0x80) add(static_cast<char>(_codepoint));
+                        else if (_codepoint < 0x800) {
+                            add(static_cast<char>(0xC0 | (_codepoint >> 6)));
+                            add(static_cast<char>(0x80 | (_codepoint & 0x3F)));
+                        } else if (_codepoint < 0x10000) {
+                            add(static_cast<char>(0xE0 | (_codepoint >> 12)));
+                            add(static_cast<char>(0x80 | ((_codepoint >> 6) & 0x3F)));
+                            add(static_cast<char>(0x80 | (_codepoint & 0x3F)));
+                        } else {
+                            add(static_cast<char>(0xF0 | (_codepoint >> 18)));
+                            add(static_cast<char>(0x80 | ((_codepoint >> 12) & 0x3F)));
+                            add(static_cast<char>(0x80 | ((_codepoint >> 6) & 0x3F)));
+                            add(static_cast<char>(0x80 | (_codepoint & 0x3F)));
+                        }
+                        break;
+                    }
+                    default: return fail("Wrong escape character");
+                    }
+                }
+
+                add({ .type = kind::string, .offset = _offset, .length = state.chars - _offset });
+                return true;
+            }
+
+            constexpr bool parse_number() {
+                std::size_t _begin = index;
+                bool _negative = consume('-');
+                auto _digits = [&] {
+                    std::size_t _start = index;
+                    while (!at_end() && is_digit(text[index])) ++index;
+                    return index - _start;
+                };
+
+                if (!consume('0') && _digits() == 0) return fail("Expected value");
+                bool _integer = true;
+                if (consume('.')) {
+                    _integer = false;
+                    if (_digits() == 0) return fail("Expected at least 1 decimal digit");
+                }
+
+                if (consume('e') || consume('E')) {
+                    _integer = false;
+                    if (!consume('+')) consume('-');
+                    if (_digits() == 0) return fail("Expected at least 1 exponent digit");
+                }
+
+                std::string_view _text = text.substr(_begin, index - _begin);
+                if (_integer) {
+                    std::uint64_t _value = 0;
+                    bool _overflow = false;
+                    for (char c : _text.substr(_negative)) {
+                        std::uint64_t _digit = c - '0';
+                        _overflow |= _value > (std::numeric_limits<std::uint64_t>::max() - _digit) / 10;
+                        _value = _value * 10 + _digit;
+                    }
+
+                    constexpr std::uint64_t _minimum = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + 1;
+                    if (!_overflow && !_negative) {
+                        add({ .type = kind::unsigned_number, .integer = _value });
+                        return true;
+                    } else if (!_overflow && _value <= _minimum) {
+                        add({ .type = kind::signed_number, .integer = ~_value + 1 }); // Two's complement of the negated value
+                        return true;
+                    }
+                }
+
+                // Floating point, or an integer too large for 64 bits, converted at runtime
+                std::size_t _offset = state.chars;
+                for (char c : _text) add(c);
+                add('\0');
+                add({ .type = kind::floating_number, .offset = _offset, .length = _text.size() });
+                return true;
+            }
+
+            // ------------------------------------------------
 
-                // When true, it should return, when false it should continue with the next
-                // potential path. If this returns true, it either succeeded, or was fatal
-                // and it must stop parsing.
-                explicit operator bool() const {
-                    return _state == parse_result_state::success
-                        || _state == parse_result_state::fatal;
+            static basic_json build(const token* tokens, const char* chars, std::size_t& index) {
+                const token& _token = tokens[index++];
+                switch (_token.type) {
+                case kind::object: {
+                    object_t _result;
+                    for (std::size_t i = 0; i < _token.size; ++i) {
+                        const token& _key = tokens[index++];
+                        string_t _name{ chars + _key.offset, _key.length };
+                        _result.put({ std::move(_name), build(tokens, chars, index) }, _result.end());
+                    }
+                    return _result;
                 }
-            };
-            
-            template<>
-            struct parse_result<void> {
-                std::vector<error_result> _errors;
-                parse_result_state _state;
-                
-                template<class T, class Self>
-                Self&& merge_errors(this Self&& self, parse_result<T>&& other) {
-                    self._errors.append_range(std::move(other._errors));
-                    return std::forward<Self>(self);
+                case kind::array: {
+                    array_t _result;
+                    _result.reserve(_token.size);
+                    for (std::size_t i = 0; i < _token.size; ++i) _result.push_back(build(tokens, chars, index));
+                    return _result;
                 }
-                
-                template<class T, class Self>
-                Self&& merge_errors(this Self&& self, const parse_result<T>& other) {
-                    self._errors.append_range(other._errors);
-                    return std::forward<Self>(self);
+                case kind::string: return string_t{ chars + _token.offset, _token.length };
+                case kind::unsigned_number: return _token.integer;
+                case kind::signed_number: return static_cast<std::int64_t>(_token.integer);
+                case kind::floating_number: {
+                    double _value = 0;
+                    from_chars(chars + _token.offset, chars + _token.offset + _token.length, _value);
+                    return _value;
+                }
+                case kind::boolean: return _token.integer != 0;
+                default: return nullptr;
                 }
+            }
 
-                bool has_value() const { return false; }
-                void value() const { return; }
+            // ------------------------------------------------
 
-                bool fatal() const { return _state == parse_result_state::fatal; }
-                bool recoverable() const { return _state == parse_result_state::recoverable; }
-                bool success() const { return _state == parse_result_state::success; }
+        };
 
-                // When true, it should return, when false it should continue with the next
-                // potential path. If this returns true, it either succeeded, or was fatal
-                // and it must stop parsing.
-                explicit operator bool() const {
-                    return _state == parse_result_state::success
-                        || _state == parse_result_state::fatal;
-                }
+        // ------------------------------------------------
+
+        // Holds the current version of a document that is read by many threads and replaced 
+        // now and then, like a configuration that is reloaded. Reading takes no lock, and only
+        // writes to a slot of its own; old versions are deleted once no snapshot uses them.
+        class store {
+            struct slot;
+
+        public:
+            struct version {
+                std::unique_ptr<const basic_json> document;
+                std::uint64_t number = 0;
             };
 
             // ------------------------------------------------
 
-            std::string_view original;
-            std::string_view value = original;
+            // Read-only access to one version, which stays alive until the snapshot is destroyed.
+            // Snapshots should not outlive their store.
+            class snapshot {
+            public:
+                snapshot(snapshot&& other) noexcept 
+                    : owner(other.owner),
+                      current(std::exchange(other.current, nullptr)), 
+                      slot(std::exchange(other.slot, nullptr)) 
+                {}
 
-            // ------------------------------------------------
+                snapshot& operator=(snapshot&& other) noexcept {
+                    if (this != &other) {
+                        release();
+                        owner = other.owner;
+                        current = std::exchange(other.current, nullptr);
+                        slot = std::exchange(other.slot, nullptr);
+                    }
+                    return *this;
+                }
 
-            struct backup_struct {
+                ~snapshot() { release(); }
 
                 // ------------------------------------------------
 
-                parser* self;
-                std::string_view backup;
+                const basic_json& operator*() const { return *current->document; }
+                const basic_json* operator->() const { return current->document.get(); }
+                std::uint64_t version() const { return current->number; }
 
                 // ------------------------------------------------
 
-                void do_revert() { self->value = backup; }
+            private:
+                friend class store;
 
-                // ------------------------------------------------
+                const store* owner;
+                const store::version* current;
+                store::slot* slot;
 
-                parse_result<> revert_as_success() {
-                    do_revert();
-                    return { 
-                        ._state = parse_result_state::success,
-                    };
-                }
-                
-                parse_result<> warning(error_message message) {
-                    std::string_view parsed = self->original.substr(0, self->original.size() - self->value.size());
-                    do_revert();
-                    return { 
-                        ._errors = { error_result{ parsed, message } },
-                        ._state = parse_result_state::success,
-                    };
-                }
-                
-                parse_result<> revert(error_message message) {
-                    std::string_view parsed = self->original.substr(0, self->original.size() - self->value.size());
-                    do_revert();
-                    return { 
-                        ._errors = { error_result{ parsed, message } },
-                        ._state = parse_result_state::recoverable,
-                    };
-                }
-                
-                parse_result<> fail(error_message message) {
-                    std::string_view parsed = self->original.substr(0, self->original.size() - self->value.size());
-                    do_revert();
-                    return { 
-                        ._errors = { error_result{ parsed, message } },
-                        ._state = parse_result_state::fatal,
-                    };
-                }
-                
-                parse_result<> revert() {
-                    do_revert();
-                    return { 
-                        ._state = parse_result_state::recoverable,
-                    };
+                snapshot(const store* owner, const store::version* current, store::slot* slot) : owner(owner), current(current), slot(slot) {}
+
+                void release() {
+                    if (!slot) return;
+                    slot->hazard.store(nullptr, std::memory_order_seq_cst);
+                    slot->claimed.store(false, std::memory_order_release);
+                    slot = nullptr;
+                    owner->reclaim_released();
                 }
-                
-                parse_result<> fail() {
-                    do_revert();
-                    return { 
-                        ._state = parse_result_state::fatal,
-                    };
+            };
+
+            // ------------------------------------------------
+
+            // Every snapshot that exists at the same time takes a slot, slots are searched
+            // starting from one picked by thread, so threads rarely contend for them. When all
+            // slots are taken, more are allocated, and kept until the store is destroyed.
+            store() : store(basic_json{}) {}
+            explicit store(basic_json document, std::size_t slots = default_slots())
+                : slots(std::make_unique<store::slot[]>(slots)), slot_count(slots),
+                  current(new version{ std::make_unique<const basic_json>(std::move(document)), 0 })
+            {}
+
+            store(const store&) = delete;
+            store& operator=(const store&) = delete;
+
+            ~store() {
+                delete current.load(std::memory_order_relaxed);
+                for (auto old : retired) delete old;
+                for (auto extra = overflow.load(std::memory_order_relaxed); extra;) delete std::exchange(extra, extra->next);
+            }
+
+            // ------------------------------------------------
+
+            snapshot load() const {
+                store::slot& slot = claim();
+                const version* latest = current.load(std::memory_order_acquire);
+                while (true) { // Only repeats when a new version was published in between
+                    slot.hazard.store(latest, std::memory_order_seq_cst);
+                    const version* check = current.load(std::memory_order_seq_cst);
+                    if (check == latest) return { this, latest, &slot };
+                    latest = check;
                 }
+            }
 
-                // ------------------------------------------------
+            // Replaces the current version, returns the number of the new version. The old version
+            // is deleted now if no snapshot uses it, otherwise when the last snapshot using it is
+            // released, or by a later publish if a publish was running at that moment.
+            std::uint64_t publish(basic_json document) {
+                std::lock_guard lock{ writer };
+                auto next = new version{ std::make_unique<const basic_json>(std::move(document)), current.load(std::memory_order_relaxed)->number + 1 };
+                retired.push_back(current.exchange(next, std::memory_order_seq_cst));
+                reclaim();
+                return next->number;
+            }
+
+            // Old versions still used by a snapshot
+            std::size_t pending() const {
+                std::lock_guard lock{ writer };
+                return retired.size();
+            }
 
+            // ------------------------------------------------
+
+        private:
+            struct alignas(64) slot {
+                std::atomic<bool> claimed = false;
+                std::atomic<const version*> hazard = nullptr; // Version in use by the snapshot
+                slot* next = nullptr;                         // Of the overflow list
             };
 
             // ------------------------------------------------
 
-            backup_struct backup() { return backup_struct{ this, value }; }
-            parse_result<> success() { return backup().revert_as_success(); }
-            parse_result<> revert(error_message message) { return backup().revert(message); }
-            parse_result<> revert() { return backup().revert(); }
-            parse_result<> fail(error_message message) { return backup().fail(message); }
-            parse_result<> fail() { return backup().fail(); }
-            parse_result<> warning(error_message message) { return backup().warning(message); }
+            std::unique_ptr<slot[]> slots;
+            std::size_t slot_count;
+            mutable std::atomic<slot*> overflow = nullptr; // Slots allocated when all others were taken
+            std::atomic<const version*> current;
+            mutable std::mutex writer; // Taken by publish, and by reclaiming on release
+            mutable std::vector<const version*> retired{};
+            mutable std::atomic<std::size_t> retired_count = 0; // Size of retired, read without the lock
 
             // ------------------------------------------------
 
-            std::optional<char> consume_one_of(std::string_view chars) {
-                if (value.empty() || !one_of(value[0], chars)) return std::nullopt;
-                char result = value[0];
-                value = value.substr(1);
-                return result;
+            static std::size_t default_slots() { return std::max<std::size_t>(64, 4 * std::thread::hardware_concurrency()); }
+
+            static bool try_claim(slot& candidate) {
+                return !candidate.claimed.load(std::memory_order_relaxed) && !candidate.claimed.exchange(true, std::memory_order_acquire);
             }
-            
-            bool consume(std::string_view word) {
-                if (!value.starts_with(word)) return false;
-                value = value.substr(word.size());
-                return true;
+
+            slot& claim() const {
+                thread_local const std::size_t start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+                for (std::size_t i = 0; i < slot_count; ++i) {
+                    if (slot& candidate = slots[(start + i) % slot_count]; try_claim(candidate)) return candidate;
+                }
+
+                for (auto extra = overflow.load(std::memory_order_acquire); extra; extra = extra->next) {
+                    if (try_claim(*extra)) return *extra;
+                }
+
+                // Every slot is taken, add one instead of waiting for one to be released
+                auto extra = new slot{};
+                extra->claimed.store(true, std::memory_order_relaxed);
+                extra->next = overflow.load(std::memory_order_relaxed);
+                while (!overflow.compare_exchange_weak(extra->next, extra, std::memory_order_acq_rel));
+                return *extra;
             }
 
-            std::string_view consume_first(std::size_t i) {
-                std::size_t _end = std::min(i, value.size());
-                auto _result = value.substr(0, _end);
-                value = value.substr(_end);
-                return _result;
+            // Deletes retired versions no slot points to
+            void reclaim() const {
+                std::vector<const version*> used;
+                auto add = [&](const slot& candidate) {
+                    if (auto hazard = candidate.hazard.load(std::memory_order_seq_cst)) used.push_back(hazard);
+                };
+
+                for (std::size_t i = 0; i < slot_count; ++i) add(slots[i]);
+                for (auto extra = overflow.load(std::memory_order_acquire); extra; extra = extra->next) add(*extra);
+
+                std::erase_if(retired, [&](const version* old) {
+                    if (std::ranges::find(used, old) != used.end()) return false;
+                    delete old;
+                    return true;
+                });
+                retired_count.store(retired.size(), std::memory_order_relaxed);
             }
-            
-            std::string_view consume_while(std::string_view oneOfs) { return consume_first(value.find_first_not_of(oneOfs)); }
-            std::string_view consume_while_not(std::string_view oneOfs) { return consume_first(value.find_first_of(oneOfs)); }
 
-            // ------------------------------------------------
-            
-            std::size_t nof_characters_since_last(char find) const {
-                std::size_t parsed = original.size() - value.size();
-                std::size_t index = original.substr(0, parsed).find_last_of(find);
-                if (index == std::string_view::npos) return std::string_view::npos;
-                return parsed - index - 1;
+            // After a snapshot is released, its version might be the last one keeping a retired version
+            // alive. Skipped when a publish holds the lock, that publish reclaims instead.
+            void reclaim_released() const {
+                if (retired_count.load(std::memory_order_relaxed) == 0) return;
+                std::unique_lock lock{ writer, std::try_to_lock };
+                if (lock) reclaim();
             }
+        };
 
-            // ------------------------------------------------
+        // ------------------------------------------------
 
-            void ignore(std::string_view anyOf = whitespace) { consume_while(anyOf); }
+        // Compiled JSONPath (RFC 9535) subset: $, .name, ['name'], .*, [*], ..name, ..*, ..[...], 
+        // [index], [start:end:step], unions like [0,'name'], and filters like [?(@.level == 'error')]
+        // with ==, !=, <, <=, >, >=, &&, ||, ! and existence tests. Like projections in JMESPath,
+        // every segment applies to each match of the segment before. Matches point into the queried
+        // document, nothing is copied. A compiled query is not modified by select, so one query can
+        // be used by many threads at once.
+        class query {
+        public:
+            struct options {
+                // Segments applied to at least parallel_min_size values, and filters over arrays or objects
+                // of at least that size, are divided over this many threads. The matches are identical.
+                std::size_t threads = 1;
+                std::size_t parallel_min_size = 4096;
+            };
 
-            parse_result<> removeIgnored(bool newline = true) {
-                auto _result = parse_comment(newline);
-                if (_result.fatal()) return fail().merge_errors(_result);
-                ignore(newline ? whitespace : whitespace_no_lf);
-                return revert(); // Revert just means it should continue (no success, but also no fatal, just neutral; continue)
-            }
+            // ------------------------------------------------
+
+            explicit query(std::string_view path) { compile(path); }
 
             // ------------------------------------------------
 
-            template<class Lambda, class Assign>
-            auto maybe(Lambda&& fun, Assign&& assign) {
-                auto result = fun();
-                if (result.has_value()) {
-                    if constexpr (std::invocable<Assign, decltype(std::move(result.value()))>) {
-                        assign(std::move(result.value()));
-                    } else {
-                        assign = std::move(result.value());
-                    }
-                }
-                return result;
+            // Matches in order, valid while json is not modified
+            std::vector<const basic_json*> select(const basic_json& json) const { return select(json, options{}); }
+            std::vector<const basic_json*> select(const basic_json& json, options settings) const {
+                std::vector<const basic_json*> matches{ &json };
+                run(json, matches, 0, settings);
+                return matches;
             }
 
             // ------------------------------------------------
 
-            template<class Lambda, class Assign>
-            auto parse_list(Lambda&& fun, Assign&& assign) {
-                auto _result = maybe(fun, assign);
-                if (_result.fatal()) return _result;
+        private:
+            enum class kind { name, index, wildcard, slice, filter };
+
+            struct selector {
+                kind type = kind::wildcard;
+                std::string name;
+                std::int64_t index = 0; // Or start of slice
+                std::optional<std::int64_t> start;
+                std::optional<std::int64_t> end;
+                std::int64_t stride = 1;
+                std::size_t expression = 0; // Root of the filter
+            };
 
-                while (true) {
-                    { // First try comma
-                        auto _ = backup(); 
-                        if (auto _ignored = removeIgnored()) {
-                            return std::move(_result).merge_errors(_ignored);
-                        }
+            struct segment {
+                bool descendants = false; // Applies to the value and everything inside it
+                std::vector<selector> selectors;
+            };
 
-                        if (consume(",")) {
-                            auto _next = maybe(fun, assign);
-                            if (_next.fatal()) return std::move(_next).merge_errors(_result);
-                            if (_next.success()) {
-                                _result.merge_errors(_next);
-                                continue;
-                            }
+            enum class operation { logical_or, logical_and, logical_not, exists, equal, not_equal, less, less_equal, greater, greater_equal };
 
-                            return _result; // Do not add last error, as this just means we're done parsing the list
-                        }
-                        _.revert();
-                    }
-                    { // Otherwise try LF
-                        auto _ = backup();
-                        if (auto _ignored = removeIgnored(false)) {
-                            return std::move(_result).merge_errors(_ignored);
-                        }
+            struct operand {
+                bool absolute = false;           // Path from $, instead of from @
+                std::vector<selector> path;      // Names and indices
+                std::size_t literal = npos;      // In _literals, when not a path
+            };
 
-                        if (consume("\n")) {
-                            auto _next = maybe(fun, assign);
-                            if (_next.fatal()) return std::move(_next).merge_errors(_result);
-                            if (_next.success()) {
-                                _result.merge_errors(_next);
-                                continue;
-                            }
+            // Operands for exists and comparisons, expressions for logical operations
+            struct expression {
+                operation type;
+                std::size_t left = 0;
+                std::size_t right = 0;
+            };
 
-                            return _result;  // Do not add last error, as this just means we're done parsing the list
-                        }
-                        _.revert();
-                    }
-                    return _result;
+            constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+            std::vector<segment> _segments;
+            std::vector<expression> _expressions;
+            std::vector<operand> _operands;
+            std::vector<basic_json> _literals;
+
+            // ------------------------------------------------
+
+            void run(const basic_json& root, std::vector<const basic_json*>& matches, std::size_t index, const options& settings) const {
+                std::vector<const basic_json*> next;
+                for (; index < _segments.size(); ++index) {
+                    if (settings.threads > 1 && matches.size() >= settings.parallel_min_size) return run_parallel(root, matches, index, settings);
+                    next.clear();
+                    for (auto node : matches) apply(root, _segments[index], *node, next, settings);
+                    std::swap(matches, next);
                 }
             }
 
-            // ------------------------------------------------
+            // Divides the values over threads, which each apply the remaining segments
+            void run_parallel(const basic_json& root, std::vector<const basic_json*>& matches, std::size_t index, const options& settings) const {
+                std::size_t parts = std::min(settings.threads, matches.size());
+                std::vector<std::vector<const basic_json*>> results(parts);
+                {
+                    std::vector<std::jthread> workers;
+                    for (std::size_t i = 0; i < parts; ++i) {
+                        workers.emplace_back([&, i] {
+                            results[i].assign(matches.begin() + matches.size() * i / parts, matches.begin() + matches.size() * (i + 1) / parts);
+                            run(root, results[i], index, {});
+                        });
+                    }
+                }
 
-            parse_result<int> parse_comment(bool newline = true) {
-                for (int nofCommentsParsed = 0;; ++nofCommentsParsed) {
-                    auto _ = backup();
+                matches.clear();
+                for (auto& part : results) matches.insert(matches.end(), part.begin(), part.end());
+            }
 
-                    auto _startedHere = backup().fail("Started here");
-                    ignore(newline ? whitespace : whitespace_no_lf);
-                    if (consume("#")) consume_while_not("\n");
-                    else if (consume("//")) consume_while_not("\n");
-                    else if (consume("/*")) {
-                        bool closed = false;
-                        while (!value.empty()) {
-                            consume_while_not("*");
-                            if (consume("*") && consume("/")) { closed = true; break; }
+            void apply(const basic_json& root, const segment& step, const basic_json& node, std::vector<const basic_json*>& out, const options& settings) const {
+                for (auto& sel : step.selectors) select(root, sel, node, out, settings);
+                if (!step.descendants) return;
+                if (node.is(array)) for (auto& element : node.as<array_t>()) apply(root, step, element, out, settings);
+                else if (node.is(object)) for (auto& [key, member] : node.as<object_t>()) apply(root, step, member, out, settings);
+            }
+
+            void select(const basic_json& root, const selector& sel, const basic_json& node, std::vector<const basic_json*>& out, const options& settings) const {
+                switch (sel.type) {
+                case kind::name: if (auto member = find(node, sel.name)) out.push_back(member); break;
+                case kind::index: if (auto element = find(node, sel.index)) out.push_back(element); break;
+                case kind::wildcard: children(node, out); break;
+                case kind::slice: {
+                    if (!node.is(array) || sel.stride == 0) break;
+                    auto& arr = node.as<array_t>();
+                    std::int64_t size = static_cast<std::int64_t>(arr.size());
+                    auto normalize = [&](std::int64_t i) { return i >= 0 ? i : size + i; };
+                    // A step past the end of the array already ends the slice, so i + stride can't overflow
+                    std::int64_t stride = std::clamp<std::int64_t>(sel.stride, -size - 1, size + 1);
+                    if (stride > 0) {
+                        std::int64_t lower = std::clamp<std::int64_t>(normalize(sel.start.value_or(0)), 0, size);
+                        std::int64_t upper = std::clamp<std::int64_t>(normalize(sel.end.value_or(size)), 0, size);
+                        for (std::int64_t i = lower; i < upper; i += stride) out.push_back(&arr[i]);
+                    } else {
+                        std::int64_t upper = std::clamp<std::int64_t>(normalize(sel.start.value_or(size - 1)), -1, size - 1);
+                        std::int64_t lower = std::clamp<std::int64_t>(normalize(sel.end.value_or(-size - 1)), -1, size - 1);
+                        for (std::int64_t i = upper; lower < i; i += stride) out.push_back(&arr[i]);
+                    }
+                    break;
+                }
+                case kind::filter: {
+                    std::size_t first = out.size();
+                    children(node, out);
+                    std::size_t count = out.size() - first;
+                    if (settings.threads > 1 && count >= settings.parallel_min_size) {
+                        std::vector<char> keep(count);
+                        std::size_t parts = std::min(settings.threads, count);
+                        {
+                            std::vector<std::jthread> workers;
+                            for (std::size_t i = 0; i < parts; ++i) {
+                                workers.emplace_back([&, i] {
+                                    for (std::size_t j = count * i / parts; j < count * (i + 1) / parts; ++j) 
+                                        keep[j] = evaluate(sel.expression, *out[first + j], root);
+                                });
+                            }
                         }
-                        if (!closed) return _.fail("Expected end of multi-line comment").merge_errors(_startedHere);
+
+                        std::size_t kept = first;
+                        for (std::size_t j = 0; j < count; ++j) if (keep[j]) out[kept++] = out[first + j];
+                        out.resize(kept);
                     } else {
-                        if (nofCommentsParsed == 0) return _.revert(); // No more comments
-                        else return nofCommentsParsed;
+                        auto kept = std::remove_if(out.begin() + first, out.end(), [&](auto child) { return !evaluate(sel.expression, *child, root); });
+                        out.erase(kept, out.end());
                     }
+                    break;
+                }
                 }
             }
 
+            static void children(const basic_json& node, std::vector<const basic_json*>& out) {
+                if (node.is(array)) for (auto& element : node.as<array_t>()) out.push_back(&element);
+                else if (node.is(object)) for (auto& [key, member] : node.as<object_t>()) out.push_back(&member);
+            }
+
+            static const basic_json* find(const basic_json& node, std::string_view name) {
+                if (!node.is(object)) return nullptr;
+                auto& obj = node.as<object_t>();
+                auto it = std::ranges::find(obj, name, &object_t::value_type::first);
+                return it == obj.end() ? nullptr : &it->second;
+            }
+
+            static const basic_json* find(const basic_json& node, std::int64_t index) {
+                if (!node.is(array)) return nullptr;
+                auto& arr = node.as<array_t>();
+                if (index < 0) index += static_cast<std::int64_t>(arr.size());
+                if (index < 0 || index >= static_cast<std::int64_t>(arr.size())) return nullptr;
+                return &arr[static_cast<std::size_t>(index)];
+            }
+
             // ------------------------------------------------
 
-            parse_result<number_t> parse_number() {
-                auto _ = backup();
+            bool evaluate(std::size_t index, const basic_json& current, const basic_json& root) const {
+                const expression& expr = _expressions[index];
+                switch (expr.type) {
+                case operation::logical_or: return evaluate(expr.left, current, root) || evaluate(expr.right, current, root);
+                case operation::logical_and: return evaluate(expr.left, current, root) && evaluate(expr.right, current, root);
+                case operation::logical_not: return !evaluate(expr.left, current, root);
+                case operation::exists: return resolve(expr.left, current, root) != nullptr;
+                default: return compare(expr.type, resolve(expr.left, current, root), resolve(expr.right, current, root));
+                }
+            }
 
-                if (auto _ignored = removeIgnored()) return _ignored;
+            // Value of an operand, nullptr when the path doesn't exist
+            const basic_json* resolve(std::size_t index, const basic_json& current, const basic_json& root) const {
+                const operand& op = _operands[index];
+                if (op.literal != npos) return &_literals[op.literal];
+                const basic_json* node = op.absolute ? &root : &current;
+                for (auto& sel : op.path) {
+                    node = sel.type == kind::name ? find(*node, sel.name) : find(*node, sel.index);
+                    if (!node) return nullptr;
+                }
 
-                std::string exponent = "", pre = "", post = "";
-                bool negative = consume("-"), hasExponent = false, negativeExponent = false, fractional = false;
+                return node;
+            }
 
-                if (consume("0")) pre = "0";
-                else while (auto c = consume_one_of("0123456789")) pre += c.value();
-                if (pre.empty()) return _.revert("Expected at least 1 digit in number");
+            // Missing values only equal each other, only numbers and strings are ordered
+            static bool compare(operation type, const basic_json* left, const basic_json* right) {
+                if (!left || !right) {
+                    if (type == operation::equal) return left == right;
+                    return type == operation::not_equal && left != right;
+                }
 
-                if ((fractional = consume("."))) {
-                    while (auto c = consume_one_of("0123456789")) post += c.value();
-                    if (post.empty()) return _.fail("Expected at least 1 decimal digit");
+                if (left->is(number) && right->is(number)) {
+                    double a = left->as<double>(), b = right->as<double>();
+                    switch (type) {
+                    case operation::equal: return a == b;
+                    case operation::not_equal: return a != b;
+                    case operation::less: return a < b;
+                    case operation::less_equal: return a <= b;
+                    case operation::greater: return a > b;
+                    default: return a >= b;
+                    }
                 }
 
-                if ((hasExponent = static_cast<bool>(consume_one_of("eE")))) {
-                    if (consume("+")) negativeExponent = false;
-                    else if (consume("-")) negativeExponent = true;
-                    while (auto c = consume_one_of("0123456789")) exponent += c.value();
-                    if (exponent.empty()) return _.fail("Expected at least 1 exponent digit");
-                }
-
-                std::string fullStr = (fractional ? pre + "." + post : pre)
-                                    + (hasExponent ? (negativeExponent ? "E-" : "E+") + exponent : "");
-                if (fractional || hasExponent) {
-                    double val = 0;
-                    from_chars(fullStr.data(), fullStr.data() + fullStr.size(), val);
-                    return { negative ? -val : val };
-                } else {
-                    std::uint64_t val = 0;
-                    from_chars(fullStr.data(), fullStr.data() + fullStr.size(), val);
-                    return negative ? number_t{ -static_cast<std::int64_t>(val) } : number_t{ val };
+                if (type == operation::equal) return *left == *right;
+                if (type == operation::not_equal) return *left != *right;
+                if (!left->is(string) || !right->is(string)) return false;
+
+                auto order = left->as<string_t>() <=> right->as<string_t>();
+                switch (type) {
+                case operation::less: return order < 0;
+                case operation::less_equal: return order <= 0;
+                case operation::greater: return order > 0;
+                default: return order >= 0;
                 }
             }
 
             // ------------------------------------------------
 
-            parse_result<string_t> parse_json_string() {
-                auto _ = backup();
-                parse_result<string_t> _result = string_t{};
+            [[noreturn]] static void invalid() { throw std::runtime_error("Invalid query."); }
 
-                if (auto _ignored = removeIgnored()) return _ignored;
+            static void skip_whitespace(std::string_view& text) {
+                while (!text.empty() && one_of(text[0], " \t\n\r")) text.remove_prefix(1);
+            }
 
-                auto v = consume_one_of("\"'");
-                if (!v) return _.revert("Expected \" or ' to start json string");
-                bool smallQuote = v == '\'';
-                while (!value.empty()) {
-                    _result.value() += consume_while_not(smallQuote ? "'\\" : "\"\\");
-                    if (consume(smallQuote ? "\'" : "\"")) return _result; // String ended
-                    if (consume("\\")) { // Escaped character
-                        if (consume("\"")) _result.value() += "\"";
-                        else if (consume("\'")) _result.value() += "\'";
-                        else if (consume("\\")) _result.value() += "\\";
-                        else if (consume("/")) _result.value() += "/";
-                        else if (consume("b")) _result.value() += "\b";
-                        else if (consume("f")) _result.value() += "\f";
-                        else if (consume("n")) _result.value() += "\n";
-                        else if (consume("r")) _result.value() += "\r";
-                        else if (consume("t")) _result.value() += "\t";
-                        else if (consume("u")) _result.merge_errors(warning("Unicode is currently not supported"));
-                        else return _result.merge_errors(warning("Wrong escape character"));
-                    }
-                }
+            static bool consume(std::string_view& text, std::string_view word) {
+                skip_whitespace(text);
+                if (!text.starts_with(word)) return false;
+                text.remove_prefix(word.size());
+                return true;
+            }
 
-                return _.fail("Expected \" or ' to end json string");
+            static void expect(std::string_view& text, std::string_view word) {
+                if (!consume(text, word)) invalid();
             }
 
-            parse_result<string_t> parse_quoteless_string() {
-                auto _ = backup();
-                if (auto _ignored = removeIgnored()) return _ignored;
-                
-                if (consume_one_of("[]{},:")) return _.revert("Quoteless string cannot start with any of \"[]{},:\"");
-                auto _result = consume_while_not("\n");
-                _result = _result.substr(0, _result.find_last_not_of(whitespace) + 1);
-                return string_t{ _result }; // ^^^ Remove whitespace from end
+            void compile(std::string_view text) {
+                expect(text, "$");
+                while (true) {
+                    skip_whitespace(text);
+                    if (text.empty()) break;
+
+                    segment step;
+                    step.descendants = text.starts_with("..");
+                    if (step.descendants) text.remove_prefix(2);
+                    else if (text.starts_with('.')) text.remove_prefix(1);
+                    else if (!text.starts_with('[')) invalid();
+
+                    if (text.starts_with('[')) {
+                        text.remove_prefix(1);
+                        do step.selectors.push_back(compile_selector(text));
+                        while (consume(text, ","));
+                        expect(text, "]");
+                    } else if (text.starts_with('*')) {
+                        text.remove_prefix(1);
+                        step.selectors.push_back({ .type = kind::wildcard });
+                    } else {
+                        step.selectors.push_back({ .type = kind::name, .name = compile_name(text) });
+                    }
+
+                    _segments.push_back(std::move(step));
+                }
             }
-            
-            parse_result<string_t> parse_multiline_string() {
-                auto _ = backup();
-                if (auto _ignored = removeIgnored()) return _ignored;
-                string_t _result = "";
 
-                std::size_t _columnsBeforeStart = nof_characters_since_last('\n');
-                if (_columnsBeforeStart == std::string_view::npos) {
-                    // If no previous newline, it means we're on the first line, so just count nof parsed characters
-                    _columnsBeforeStart = original.size() - value.size();
+            // Name after a dot, letters, digits, '_', '-' and anything outside ASCII
+            static std::string compile_name(std::string_view& text) {
+                std::size_t size = 0;
+                while (size < text.size()) {
+                    unsigned char c = static_cast<unsigned char>(text[size]);
+                    if (!std::isalnum(c) && c != '_' && c != '-' && c < 0x80) break;
+                    ++size;
                 }
-                
-                auto _startedHere = backup().fail("Started here");
-                if (!consume("'''")) return _.revert("Expected ''' to start multi-line string");
-                ignore(whitespace_no_lf);
-                bool startsOnNewLine = consume("\n");
 
-                bool firstLine = true;
-                while (!value.empty()) {
-                    ignore(whitespace_no_lf);
-                    if (consume("'''")) return _result; // End of string
+                if (size == 0) invalid();
+                std::string result{ text.substr(0, size) };
+                text.remove_prefix(size);
+                return result;
+            }
 
-                    std::size_t index = nof_characters_since_last('\n');
-                    if (_columnsBeforeStart == std::string_view::npos) {
-                        // If no previous newline, it means we're on the first line, so just count nof parsed characters
-                        _columnsBeforeStart = original.size() - value.size();
-                    }
+            static std::string compile_string(std::string_view& text) {
+                skip_whitespace(text);
+                if (text.empty() || !one_of(text[0], "'\"")) invalid();
+                char quote = text[0];
+                text.remove_prefix(1);
 
-                    std::int64_t spaces = std::max(static_cast<std::int64_t>(index) - static_cast<std::int64_t>(_columnsBeforeStart), static_cast<std::int64_t>(0ll));
-                    if (firstLine && !startsOnNewLine) spaces -= 3; // remove 3 spaces to account for ''' on first line
-                    
-                    if (!firstLine) _result += '\n';
-                    else firstLine = false;
+                std::string result;
+                while (true) {
+                    if (text.empty()) invalid();
+                    char c = text[0];
+                    text.remove_prefix(1);
+                    if (c == quote) return result;
+                    if (c != '\\') {
+                        result += c;
+                        continue;
+                    }
 
-                     _result += std::string(spaces, ' ');
-                    while (!value.empty()) {
-                        _result += consume_while_not("\n'");
-                        if (consume("'''")) return _result; // End of string
-                        else if (consume("'")) _result += "'"; // ' inside string
-                        else if (consume("\n")) break;      // End of line
+                    if (text.empty()) invalid();
+                    c = text[0];
+                    text.remove_prefix(1);
+                    switch (c) {
+                    case 'b': result += '\b'; break;
+                    case 'f': result += '\f'; break;
+                    case 'n': result += '\n'; break;
+                    case 'r': result += '\r'; break;
+                    case 't': result += '\t'; break;
+                    case 'u': {
+                        auto hex4 = [&] {
+                            std::uint16_t unit = 0;
+                            auto [ptr, error] = std::from_chars(text.data(), text.data() + std::min<std::size_t>(4, text.size()), unit, 16);
+                            if (error != std::errc{} || ptr != text.data() + 4) invalid();
+                            text.remove_prefix(4);
+                            return char32_t{ unit };
+                        };
+
+                        char32_t codepoint = hex4();
+                        if (codepoint >= 0xD800 && codepoint <= 0xDBFF) { // High surrogate, must be followed by a low surrogate
+                            if (!text.starts_with("\\u")) invalid();
+                            text.remove_prefix(2);
+                            char32_t low = hex4();
+                            if (low < 0xDC00 || low > 0xDFFF) invalid();
+                            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) invalid();
+
+                        _utf8_encode(result, codepoint);
+                        break;
+                    }
+                    default: result += c; break; // Quotes, \ and /
                     }
                 }
+            }
 
-                return _.fail("Expected ''' to end multi-line string")
-                        .merge_errors(_startedHere);
+            static std::optional<std::int64_t> compile_integer(std::string_view& text) {
+                skip_whitespace(text);
+                std::int64_t result = 0;
+                auto [ptr, error] = std::from_chars(text.data(), text.data() + text.size(), result);
+                if (ptr == text.data()) return std::nullopt;
+                if (error != std::errc{}) invalid();
+                text.remove_prefix(static_cast<std::size_t>(ptr - text.data()));
+                return result;
             }
 
-            // ------------------------------------------------
+            selector compile_selector(std::string_view& text) {
+                skip_whitespace(text);
+                if (consume(text, "*")) return { .type = kind::wildcard };
+                if (consume(text, "?")) return { .type = kind::filter, .expression = compile_or(text) };
+                if (!text.empty() && one_of(text[0], "'\"")) return { .type = kind::name, .name = compile_string(text) };
 
-            parse_result<std::pair<string_t, basic_json>> parse_member() {
-                auto _ = backup();
-                parse_result<std::pair<string_t, basic_json>> _result = std::pair<string_t, basic_json>{};
-                string_t& _key = _result.value().first;
-                basic_json& _val = _result.value().second;
+                auto start = compile_integer(text);
+                if (!consume(text, ":")) {
+                    if (!start) invalid();
+                    return { .type = kind::index, .index = *start };
+                }
 
-                if (auto _ignored = removeIgnored()) return _ignored;
+                selector result{ .type = kind::slice, .start = start, .end = compile_integer(text) };
+                if (consume(text, ":")) result.stride = compile_integer(text).value_or(1);
+                return result;
+            }
 
-                auto _keyResult = parse_json_string();
-                if (_keyResult.fatal()) return _.fail().merge_errors(_keyResult);
+            std::size_t add(expression expr) {
+                _expressions.push_back(expr);
+                return _expressions.size() - 1;
+            }
 
-                if (_keyResult.has_value()) {
-                    _result.merge_errors(_keyResult);
-                    _key = std::move(_keyResult.value()); 
-                } else {
-                    _key = consume_while_not(",:[]{} \t\n\r\f\v");
-                }
+            std::size_t compile_or(std::string_view& text) {
+                std::size_t left = compile_and(text);
+                while (consume(text, "||")) left = add({ operation::logical_or, left, compile_and(text) });
+                return left;
+            }
 
-                if (_key.empty()) {
-                    return _.revert("Cannot have empty key")
-                            .merge_errors(_result);
-                }
+            std::size_t compile_and(std::string_view& text) {
+                std::size_t left = compile_unary(text);
+                while (consume(text, "&&")) left = add({ operation::logical_and, left, compile_unary(text) });
+                return left;
+            }
 
-                if (auto _ignored = removeIgnored()) {
-                    return std::move(_ignored).merge_errors(_result);
+            std::size_t compile_unary(std::string_view& text) {
+                if (consume(text, "!")) return add({ operation::logical_not, compile_unary(text) });
+                if (consume(text, "(")) {
+                    std::size_t result = compile_or(text);
+                    expect(text, ")");
+                    return result;
                 }
 
-                if (!consume(":")) {
-                    return _.fail("Expected ':' after key")
-                            .merge_errors(_result);
+                std::size_t left = compile_operand(text);
+                constexpr std::pair<std::string_view, operation> comparisons[]{
+                    { "==", operation::equal }, { "!=", operation::not_equal }, 
+                    { "<=", operation::less_equal }, { ">=", operation::greater_equal },
+                    { "<", operation::less }, { ">", operation::greater },
+                };
+
+                for (auto& [symbol, type] : comparisons) {
+                    if (consume(text, symbol)) return add({ type, left, compile_operand(text) });
                 }
 
-                auto _valueResult = parse_value();
-                _result.merge_errors(_valueResult);
-                if (_valueResult.has_value()) {
-                    _val = std::move(_valueResult.value());
-                } else if (_valueResult.fatal()) {
-                    return _.fail()
-                            .merge_errors(_result);
+                if (_operands[left].literal != npos) invalid(); // A literal is not a test
+                return add({ operation::exists, left });
+            }
+
+            std::size_t compile_operand(std::string_view& text) {
+                skip_whitespace(text);
+                operand result;
+                if (text.starts_with('@') || text.starts_with('$')) {
+                    result.absolute = text[0] == '$';
+                    text.remove_prefix(1);
+                    while (true) {
+                        if (text.starts_with('.') && !text.starts_with("..")) {
+                            text.remove_prefix(1);
+                            result.path.push_back({ .type = kind::name, .name = compile_name(text) });
+                        } else if (text.starts_with('[')) {
+                            text.remove_prefix(1);
+                            skip_whitespace(text);
+                            if (!text.empty() && one_of(text[0], "'\"")) result.path.push_back({ .type = kind::name, .name = compile_string(text) });
+                            else if (auto index = compile_integer(text)) result.path.push_back({ .type = kind::index, .index = *index });
+                            else invalid();
+                            expect(text, "]");
+                        } else break;
+                    }
+                } else {
+                    result.literal = _literals.size();
+                    _literals.push_back(compile_literal(text));
                 }
 
-                return _result;
+                _operands.push_back(std::move(result));
+                return _operands.size() - 1;
             }
 
-            // ------------------------------------------------
+            static basic_json compile_literal(std::string_view& text) {
+                if (!text.empty() && one_of(text[0], "'\"")) return compile_string(text);
+                if (consume(text, "true")) return true;
+                if (consume(text, "false")) return false;
+                if (consume(text, "null")) return nullptr;
+
+                std::size_t size = 0;
+                while (size < text.size() && one_of(text[size], "+-0123456789.eE")) ++size;
+                std::string_view number = text.substr(0, size);
+                if (number.empty()) invalid();
+                text.remove_prefix(size);
+
+                basic_json result;
+                auto convert = [&](auto value) {
+                    auto [ptr, error] = from_chars(number.data(), number.data() + number.size(), value);
+                    if (error != std::errc{} || ptr != number.data() + number.size()) invalid();
+                    result = value;
+                };
+
+                if (number.find_first_of(".eE") != std::string_view::npos) convert(0.0);
+                else if (number.starts_with('-')) convert(std::int64_t{});
+                else convert(std::uint64_t{});
+                return result;
+            }
+        };
 
-            parse_result<object_t> parse_object(bool rootValue) {
-                auto _ = backup();
-                parse_result<object_t> _result = object_t{};
+        // ------------------------------------------------
 
-                if (auto _ignored = removeIgnored()) return _ignored;
+        // Struct-of-arrays form of an array of objects. Every path to a value that is not a non-empty 
+        // object, like user.name, becomes a column with a contiguous buffer of one type, and a 
+        // validity bitmap that is 0 for rows where the value is null or missing. Column types are
+        // inferred while adding rows, and widen when a later row needs it: integers to floating
+        // point, and anything mixed, arrays and empty objects to json values. Rows are added in a 
+        // single pass, a member is found by trying the member that came next in the last row first.
+        class table {
+        public:
+            enum class column_type { null, boolean, unsigned_integer, signed_integer, floating_point, string, json };
+
+            struct strings {
+                std::vector<std::size_t> offsets{ 0 }; // Row i is chars[offsets[i], offsets[i + 1])
+                std::string chars;
+
+                std::string_view operator[](std::size_t row) const { return std::string_view{ chars }.substr(offsets[row], offsets[row + 1] - offsets[row]); }
+            };
 
-                bool startedWithBrace = true;
-                if (!consume("{")) {
-                    if (rootValue) {
-                        startedWithBrace = false;
-                    } else {
-                        return _.revert("Expected '{' to begin Object");
-                    }
+            struct column {
+                std::vector<std::string> path; // Member names from the record to the value
+                std::vector<std::uint64_t> validity; // Bit per row, set when the value is not null or missing
+                // A value per row, 0 or empty when not valid. Index matches column_type.
+                std::variant<std::monostate, std::vector<std::uint8_t>, std::vector<std::uint64_t>, 
+                    std::vector<std::int64_t>, std::vector<double>, strings, std::vector<basic_json>> values;
+
+                column_type type() const { return static_cast<column_type>(values.index()); }
+                bool valid(std::size_t row) const { return row / 64 < validity.size() && ((validity[row / 64] >> (row % 64)) & 1); }
+
+                // Buffer of booleans (std::uint8_t), integers, doubles, or json values
+                template<class Ty>
+                std::span<const Ty> data() const { return std::get<std::vector<Ty>>(values); }
+                const strings& text() const { return std::get<strings>(values); }
+
+                // Value of a row as json, null when not valid
+                basic_json at(std::size_t row) const {
+                    if (!valid(row)) return nullptr;
+                    return std::visit([&]<class Ty>(const Ty& buffer) -> basic_json {
+                        if constexpr (std::same_as<Ty, std::monostate>) return nullptr;
+                        else if constexpr (std::same_as<Ty, std::vector<std::uint8_t>>) return buffer[row] != 0;
+                        else if constexpr (std::same_as<Ty, strings>) return string_t{ buffer[row] };
+                        else return buffer[row];
+                    }, values);
                 }
-                
-                auto _list = parse_list(
-                    [&] { return parse_member(); }, 
-                    [&](auto&& val) { _result.value().put(std::move(val), _result.value().end()); }
-                );
+            };
 
-                if (_list.fatal()) return _.fail().merge_errors(_list);
-                if (!_result.value().empty()) {
-                    _result.merge_errors(_list);
-                }
+            // ------------------------------------------------
 
-                if (auto _ignored = removeIgnored()) {
-                    return std::move(_ignored).merge_errors(_result);
-                }
+            table() = default;
+            explicit table(const basic_json& records) {
+                if (!records.is(array)) throw std::runtime_error("Invalid type.");
+                for (auto& record : records.as<array_t>()) append(record);
+            }
 
-                if (startedWithBrace && !consume("}")) {
-                    return _.fail("Expected '}' to close Object")
-                            .merge_errors(_result);
+            // Shreds a json array while parsing it, each record is added and released once parsed.
+            // Input the structure_scanner can't split, or with a schema, is parsed as a whole first.
+            static parser::result<table> shred(std::string_view json) { return shred(json, parser::parse_options{}); }
+            static parser::result<table> shred(std::string_view json, parser::parse_options options) {
+                if (!options.schema) {
+                    std::vector<std::size_t> _separators;
+                    parser::structure_scanner _scanner;
+                    _scanner.scan(json, true, [&](std::size_t comma) { _separators.push_back(comma); });
+                    parser _rest{ json, _scanner.done() ? json.substr(_scanner.end + 1) : json, options };
+                    // Comments in front of the opening '[' are only scanned, not parsed
+                    bool _valid = _scanner.done() && (!options.validate_utf8 || validate_utf8(json.substr(0, _scanner.begin)));
+                    if (_valid && !_rest.removeIgnored().fatal() && _rest.value.empty()) {
+                        _separators.push_back(_scanner.end);
+                        table _result;
+                        std::size_t _start = _scanner.begin;
+                        for (std::size_t i = 0; i < _separators.size(); ++i) {
+                            bool _last = i + 1 == _separators.size();
+                            parser _parser = parser::for_part(json, json.substr(_start, _separators[i] - _start), options, 1);
+                            auto _parsed = _parser.parse_elements(_last);
+                            if (!_parsed) break;
+                            for (auto& _record : _parsed->value()) {
+                                if (!_record.is(object)) throw std::runtime_error("Invalid type.");
+                                _result.append(_record);
+                            }
+                            if (_last) return _result;
+                            _start = _separators[i] + 1;
+                        }
+                    }
                 }
 
+                // Not splittable, or invalid, parse everything for the exact errors
+                parser _parser{ json, json, options };
+                auto _parsed = _parser.parse_root();
+                parser::result<table> _result = parser::parse_result<>{ ._errors = std::move(_parsed._errors), ._state = _parsed._state };
+                if (_parsed.has_value()) _result._value.emplace(_parsed.value());
+                _result._stats = _parser.stats;
                 return _result;
             }
 
             // ------------------------------------------------
 
-            parse_result<array_t> parse_array(bool rootValue) {
-                auto _ = backup();
-                parse_result<array_t> _result = array_t{};
+            void append(const basic_json& record) {
+                if (!record.is(object)) throw std::runtime_error("Invalid type.");
+                add(0, record);
+                ++_rows;
+                for (auto& col : _columns) while (_sizes[&col - _columns.data()] < _rows) put(col, nullptr);
+            }
 
-                if (auto _ignored = removeIgnored()) return _ignored;
+            // ------------------------------------------------
 
-                bool startedWithBrace = true;
-                if (!consume("[")) {
-                    if (rootValue) {
-                        startedWithBrace = false;
-                    } else {
-                        return _.revert("Expected '[' to begin Array");
-                    }
-                }
-                
-                auto _list = parse_list(
-                    [&] { return parse_value(false); }, 
-                    [&](auto&& val) { _result.value().push_back(std::move(val)); }
-                );
+            std::size_t rows() const { return _rows; }
+            const std::vector<column>& columns() const { return _columns; }
 
-                if (_list.fatal()) return _.fail().merge_errors(_list);
-                if (!_result.value().empty()) {
-                    _result.merge_errors(_list);
+            const column* find(std::string_view path) const { // Member names joined by '.'
+                for (auto& col : _columns) {
+                    std::string joined;
+                    for (auto& key : col.path) joined += (joined.empty() ? "" : ".") + key;
+                    if (joined == path) return &col;
                 }
+                return nullptr;
+            }
 
-                if (auto _ignored = removeIgnored()) {
-                    return std::move(_ignored).merge_errors(_result);
-                }
+            // ------------------------------------------------
 
-                if (startedWithBrace && !consume("]")) {
-                    return _.fail("Expected ']' to close Array")
-                            .merge_errors(_result);
+            // Record of a row, null and missing values are left out
+            basic_json row(std::size_t index) const {
+                basic_json result = object_t{};
+                for (auto& col : _columns) {
+                    if (!col.valid(index)) continue;
+                    basic_json* target = &result;
+                    for (auto& key : col.path) target = &(*target)[key];
+                    *target = col.at(index);
                 }
+                return result;
+            }
 
-                return _result;
+            basic_json to_json() const {
+                array_t result;
+                result.reserve(_rows);
+                for (std::size_t i = 0; i < _rows; ++i) result.push_back(row(i));
+                return result;
             }
 
             // ------------------------------------------------
 
-            parse_result<basic_json> parse_value_ambiguous() {
-                auto _ = backup();
-                parse_result<basic_json> _result = basic_json{};
+        private:
+            constexpr static std::size_t npos = static_cast<std::size_t>(-1);
 
-                if (auto _ignored = removeIgnored()) return _ignored;
+            struct path_node {
+                std::vector<std::pair<std::string, std::size_t>> children; // Member name, node
+                std::size_t column = npos;
+                std::size_t next = 0; // Child of the member after the last one found
+            };
 
-                if (consume("true")) _result.value() = true;
-                else if (consume("false")) _result.value() = false;
-                else if (consume("null")) _result.value() = nullptr;
-                else if (maybe([&] { return parse_number(); }, _result.value()).has_value());
-                else return _.revert("Not a potentially ambiguous value");
+            std::vector<column> _columns;
+            std::vector<std::size_t> _sizes; // Rows in each column
+            std::vector<path_node> _nodes{ 1 }; // Root at index 0
+            std::vector<std::string> _path;      // Of the member being added
+            std::size_t _rows = 0;
 
-                // Because after a true/false/null/number there could be other characters that
-                // could turn it into a string check whether this really is the parsed type.
-                auto temp = backup(); // backup, because we don't want to actually consume 
-                ignore(whitespace_no_lf);
-                auto _comment = parse_comment();
-                if (_comment.fatal()) return _comment;
-                if (_comment.has_value() || consume_one_of("\n,][}{:") || value.empty()) {
-                    temp.revert();
-                    return _result;
+            // ------------------------------------------------
+
+            void add(std::size_t index, const basic_json& record) {
+                _nodes[index].next = 0;
+                for (auto& [key, val] : record.as<object_t>()) {
+                    std::size_t child = child_of(index, key);
+                    _path.push_back(key);
+                    if (val.is(object) && !val.empty()) add(child, val);
+                    else {
+                        std::size_t col = column_of(child);
+                        if (_sizes[col] == _rows) put(_columns[col], val); // Only the first of duplicate paths
+                    }
+                    _path.pop_back();
+                }
+            }
+
+            std::size_t child_of(std::size_t index, std::string_view key) {
+                auto& children = _nodes[index].children;
+                std::size_t& next = _nodes[index].next;
+                if (next < children.size() && children[next].first == key) return children[next++].second;
+                auto it = std::ranges::find(children, key, &std::pair<std::string, std::size_t>::first);
+                if (it != children.end()) {
+                    next = static_cast<std::size_t>(it - children.begin()) + 1;
+                    return it->second;
                 }
 
-                return _.revert("Value turned out to be a string");
+                std::size_t child = _nodes.size();
+                children.emplace_back(key, child);
+                next = children.size();
+                _nodes.emplace_back(); // Invalidates children
+                return child;
             }
 
-            parse_result<basic_json> parse_value(bool failWhenNo = true, bool rootValue = false) {
-                if (auto _object = parse_object(rootValue)) return _object;
-                if (auto _array = parse_array(rootValue)) return _array;
-                if (auto _ambig = parse_value_ambiguous()) return _ambig;
-                if (auto _str = parse_multiline_string()) return _str;
-                if (auto _str = parse_json_string()) return _str;
-                if (auto _str = parse_quoteless_string()) return _str;
-                return failWhenNo ? fail("Expected value") : revert();
+            std::size_t column_of(std::size_t node) {
+                if (_nodes[node].column != npos) return _nodes[node].column;
+                _nodes[node].column = _columns.size();
+                _columns.push_back({ .path = _path });
+                _sizes.push_back(0);
+                while (_sizes.back() < _rows) put(_columns.back(), nullptr); // Missing in earlier rows
+                return _columns.size() - 1;
             }
 
             // ------------------------------------------------
 
-        };
+            static column_type type_of(const basic_json& val) {
+                switch (val.type()) {
+                case null: return column_type::null;
+                case boolean: return column_type::boolean;
+                case string: return column_type::string;
+                case number: {
+                    auto number = val._number();
+                    if (std::holds_alternative<double>(number)) return column_type::floating_point;
+                    if (std::holds_alternative<std::int64_t>(number)) return column_type::signed_integer;
+                    return column_type::unsigned_integer;
+                }
+                default: return column_type::json;
+                }
+            }
 
-        // ------------------------------------------------
-        
-        static parser::result<basic_json> parse(std::string_view json) { return parser{ json }.parse_value(true, true); }
+            // Type that holds values of both
+            static column_type widen(column_type a, column_type b, const column& col, const basic_json& val) {
+                if (a == b || b == column_type::null) return a;
+                if (a == column_type::null) return b;
+                auto integer = [](column_type type) { return type == column_type::unsigned_integer || type == column_type::signed_integer; };
+                auto numeric = [&](column_type type) { return integer(type) || type == column_type::floating_point; };
+                if (!numeric(a) || !numeric(b)) return column_type::json;
+                if (!integer(a) || !integer(b)) return column_type::floating_point;
+
+                // Signed and unsigned, signed unless an unsigned value doesn't fit
+                constexpr auto limit = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+                if (b == column_type::unsigned_integer) return val.as<std::uint64_t>() > limit ? column_type::floating_point : column_type::signed_integer;
+                bool fits = std::ranges::all_of(col.data<std::uint64_t>(), [&](std::uint64_t v) { return v <= limit; });
+                return fits ? column_type::signed_integer : column_type::floating_point;
+            }
+
+            // Converts the values of the column to type
+            static void convert(column& col, column_type type, std::size_t size) {
+                if (col.type() == type) return;
+                decltype(column::values) values;
+                auto fill = [&]<class Ty>(std::in_place_type_t<Ty>) {
+                    auto& buffer = values.template emplace<std::vector<Ty>>();
+                    buffer.reserve(size);
+                    for (std::size_t i = 0; i < size; ++i) {
+                        if constexpr (std::same_as<Ty, basic_json>) buffer.push_back(col.at(i));
+                        else buffer.push_back(col.valid(i) ? col.at(i).template as<Ty>() : Ty{});
+                    }
+                };
+
+                switch (type) {
+                case column_type::boolean: fill(std::in_place_type<std::uint8_t>); break;
+                case column_type::unsigned_integer: fill(std::in_place_type<std::uint64_t>); break;
+                case column_type::signed_integer: fill(std::in_place_type<std::int64_t>); break;
+                case column_type::floating_point: fill(std::in_place_type<double>); break;
+                case column_type::json: fill(std::in_place_type<basic_json>); break;
+                case column_type::string: {
+                    auto& buffer = values.template emplace<strings>();
+                    buffer.offsets.assign(size + 1, 0); // Only from null, all empty
+                    break;
+                }
+                default: break;
+                }
+
+                col.values = std::move(values);
+            }
+
+            // Appends a row to the column
+            void put(column& col, const basic_json& val) {
+                std::size_t& size = _sizes[&col - _columns.data()];
+                column_type type = type_of(val);
+                if (type != column_type::null) convert(col, widen(col.type(), type, col, val), size);
+
+                if (size % 64 == 0) col.validity.push_back(0);
+                if (type != column_type::null) col.validity.back() |= std::uint64_t{ 1 } << (size % 64);
+                ++size;
+
+                std::visit([&]<class Ty>(Ty& buffer) {
+                    if constexpr (std::same_as<Ty, std::monostate>) return;
+                    else if constexpr (std::same_as<Ty, strings>) {
+                        if (type != column_type::null) buffer.chars += val.as<string_t>();
+                        buffer.offsets.push_back(buffer.chars.size());
+                    } else if constexpr (std::same_as<Ty, std::vector<basic_json>>) buffer.push_back(val);
+                    else if constexpr (std::same_as<Ty, std::vector<std::uint8_t>>) buffer.push_back(type != column_type::null && val.as<bool>());
+                    else buffer.push_back(type != column_type::null ? val.as<typename Ty::value_type>() : typename Ty::value_type{});
+                }, col.values);
+            }
+        };
 
         // ------------------------------------------------
         
     private:
-        constexpr static std::string escape(std::string_view str) {
-            std::string _str{ str };
-            string_replace(_str, "\\", "\\\\");
-            string_replace(_str, "\b", "\\b");
-            string_replace(_str, "\f", "\\f");
-            string_replace(_str, "\n", "\\n");
-            string_replace(_str, "\r", "\\r");
-            string_replace(_str, "\t", "\\t");
-            string_replace(_str, "\"", "\\\"");
-            string_replace(_str, "\'", "\\'");
-            string_replace(_str, "/", "\\/");
-            return _str;
-        }
-
         constexpr static bool one_of(char c, std::string_view cs) { return cs.find(c) != std::string_view::npos; }
 
         constexpr static void string_replace(std::string& str, std::string_view from, std::string_view to) {
@@ -1376,7 +5869,65 @@ namespace kaixo {
     inline std::ostream& operator<<(std::ostream& stream, const basic_json& object) { return stream << object.to_string(); }
 
     // ------------------------------------------------
+
+    // Document of a _json literal. The text is parsed during compilation, at runtime the
+    // document is built from the parsed tokens once, and shared by all copies.
+    template<fixed_string Text>
+    struct json_literal {
+        using parser = basic_json::literal_parser;
+
+        constexpr static parser::result counts = parser::parse(Text.view());
+
+        struct parsed {
+            std::array<parser::token, counts.tokens> tokens{};
+            std::array<char, counts.chars + 1> chars{};
+        };
+
+        constexpr static parsed document = [] {
+            parsed _result;
+            parser::parse(Text.view(), _result.tokens.data(), _result.chars.data());
+            return _result;
+        }();
+
+        static const basic_json& value() {
+            static const basic_json _value = [] {
+                basic_json _result = parser::build(document.tokens.data(), document.chars.data());
+                _result.share();
+                return _result;
+            }();
+            return _value;
+        }
+
+        operator const basic_json&() const { return value(); }
+        const basic_json& operator*() const { return value(); }
+        const basic_json* operator->() const { return &value(); }
+    };
+
+    // Fails to compile when called, which is how syntax errors in _json literals are reported. The
+    // message and the position in the literal are template arguments, so the compiler shows them.
+    template<fixed_string Message, std::size_t Position>
+    void json_literal_syntax_error() {}
+
+    inline namespace literals {
+        template<fixed_string Text>
+        consteval json_literal<Text> operator""_json() {
+            constexpr auto _result = basic_json::literal_parser::parse(Text.view());
+            if constexpr (_result.error.has_value()) {
+                json_literal_syntax_error<fixed_string<_result.error->message.size() + 1>{ _result.error->message }, _result.position>();
+            }
+            return {};
+        }
+    }
+
+    // ------------------------------------------------
     
 }
 
 // ------------------------------------------------
+
+template<>
+struct std::hash<kaixo::basic_json> {
+    std::size_t operator()(const kaixo::basic_json& json) const { return json.hash(); }
+};
+
+// ------------------------------------------------
@@ -5,6 +5,12 @@
 
 // ------------------------------------------------
 
+#include <deque>
+#include <map>
+#include <string>
+
+// ------------------------------------------------
+
 #include "basic_json.hpp"
 
 // ------------------------------------------------
@@ -160,7 +166,1070 @@ namespace kaixo::test {
     }
 
     // ------------------------------------------------
-    
+
+    TEST(BasicJsonTests, SharedCopyOnWrite) {
+        basic_json base{
+            { "a", 1 },
+            { "b", basic_json{ { "c", "value" } } },
+            { "d", basic_json::array_t{ 1, 2, 3 } },
+        };
+
+        base.share();
+        basic_json copy = base;
+        const basic_json& _base = base;
+        const basic_json& _copy = copy;
+
+        ASSERT_TRUE(copy.is_shared());
+        ASSERT_EQ(&_base.at("b"), &_copy.at("b"));
+
+        copy["b"]["c"] = "other";
+
+        ASSERT_EQ(_base.at("b").at("c").as<std::string_view>(), "value");
+        ASSERT_EQ(_copy.at("b").at("c").as<std::string_view>(), "other");
+        ASSERT_EQ(&_base.at("d").as<basic_json::array_t>(), &_copy.at("d").as<basic_json::array_t>());
+        ASSERT_EQ(base.get("d"), copy.get("d"));
+        ASSERT_NE(base, copy);
+    }
+
+    // ------------------------------------------------
+
+    TEST(BasicJsonTests, HashAndEquality) {
+        ASSERT_EQ(basic_json{ 1 }, basic_json{ 1. });
+        ASSERT_EQ(basic_json{ 1 }, basic_json{ 1u });
+        ASSERT_NE(basic_json{ 1 }, basic_json{ 1.5 });
+        ASSERT_NE(basic_json{ -1 }, basic_json{ std::numeric_limits<std::uint64_t>::max() });
+        ASSERT_EQ(basic_json{ 1 }.hash(), basic_json{ 1. }.hash());
+        ASSERT_EQ(basic_json{ 1u }.hash(), basic_json{ 1. }.hash());
+        ASSERT_EQ(basic_json{ 0. }.hash(), basic_json{ -0. }.hash());
+
+        basic_json a{ { "a", 1 }, { "b", basic_json::array_t{ 1, "2" } } };
+        basic_json b{ { "b", basic_json::array_t{ 1u, "2" } }, { "a", 1. } };
+
+        ASSERT_NE(a, b);
+        ASSERT_TRUE(a.equals(b, { .ignore_key_order = true }));
+        ASSERT_EQ(a.hash(), b.hash());
+        ASSERT_EQ(std::hash<basic_json>{}(a), a.hash());
+        ASSERT_NE(a.hash(), (basic_json{ { "a", 2 } }.hash()));
+
+        std::size_t hash = a.hash();
+        a.share();
+        ASSERT_EQ(a.hash(), hash);
+        ASSERT_EQ(basic_json{ a }.hash(), hash);
+    }
+
+    // ------------------------------------------------
+
+    TEST(BasicJsonTests, Merge) {
+        basic_json result{ { "a", 1 }, { "b", basic_json{ { "c", 1 } } } };
+        result.merge(basic_json{ { "a", 2 }, { "b", basic_json{ { "c", 2 }, { "d", 2 } } }, { "e", 2 } });
+
+        ASSERT_EQ(result, (basic_json{
+            { "e", 2 },
+            { "a", 1 },
+            { "b", basic_json{ { "d", 2 }, { "c", 1 } } },
+        }));
+
+        basic_json large, other;
+        for (int i = 0; i < 100; ++i) large.put(std::to_string(i), i);
+        for (int i = 50; i < 150; ++i) other.put(std::to_string(i), -i);
+        large.merge(std::move(other), { .overwrite = true });
+
+        ASSERT_EQ(large.size(), 150);
+        ASSERT_EQ(large.at("0").as<int>(), 0);
+        ASSERT_EQ(large.at("50").as<int>(), -50);
+        ASSERT_EQ(large.at("149").as<int>(), -149);
+
+        basic_json arrays{ { "a", basic_json::array_t{ 1 } } };
+        arrays.merge(basic_json{ { "a", basic_json::array_t{ 2 } } }, { .concat_arrays = true });
+        ASSERT_EQ(arrays.at("a"), (basic_json::array_t{ 1, 2 }));
+    }
+
+    TEST(BasicJsonTests, MergePatch) {
+        auto target = basic_json::parse(R"~~({
+            "title": "Goodbye!",
+            "author": { "givenName": "John", "familyName": "Doe" },
+            "tags": [ "example", "sample" ],
+            "content": "This will be unchanged"
+        })~~");
+
+        auto patch = basic_json::parse(R"~~({
+            "title": "Hello!",
+            "phoneNumber": "+01-555-1234",
+            "author": { "familyName": null },
+            "tags": [ "example" ]
+        })~~");
+
+        ASSERT_TRUE(target.has_value());
+        ASSERT_TRUE(patch.has_value());
+
+        target->merge_patch(patch.value());
+
+        ASSERT_EQ(target.value(), (basic_json{
+            { "phoneNumber", "+01-555-1234" },
+            { "title", "Hello!" },
+            { "author", basic_json{ { "givenName", "John" } } },
+            { "tags", basic_json::array_t{ "example" } },
+            { "content", "This will be unchanged" },
+        }));
+    }
+
+    // ------------------------------------------------
+
+    TEST(BasicJsonTests, Diff) {
+        basic_json from{
+            { "a", 1 },
+            { "b", basic_json::array_t{ 1, 2, 3, 4 } },
+            { "c", basic_json{ { "d", 1 } } },
+            { "f", "removed" },
+        };
+
+        basic_json to{
+            { "a", 2 },
+            { "b", basic_json::array_t{ 1, 3, 4, 5 } },
+            { "c", basic_json{ { "d", 1 }, { "e/~", "x" } } },
+        };
+
+        basic_json patch = basic_json::diff(from, to);
+        ASSERT_EQ(patch, (basic_json::array_t{
+            basic_json{ { "op", "replace" }, { "path", "/a" }, { "value", 2 } },
+            basic_json{ { "op", "remove" }, { "path", "/b/1" } },
+            basic_json{ { "op", "add" }, { "path", "/b/3" }, { "value", 5 } },
+            basic_json{ { "op", "add" }, { "path", "/c/e~1~0" }, { "value", "x" } },
+            basic_json{ { "op", "remove" }, { "path", "/f" } },
+        }));
+
+        ASSERT_TRUE(from.apply_patch(patch));
+        ASSERT_EQ(from, to);
+        ASSERT_TRUE(basic_json::diff(from, to).empty());
+
+        // Reordered records, matched through their hashes
+        basic_json records = basic_json::array_t{ basic_json{ { "id", 1 } }, basic_json{ { "id", 2 } }, basic_json{ { "id", 3 } } };
+        basic_json moved = basic_json::array_t{ basic_json{ { "id", 2 } }, basic_json{ { "id", 3 } }, basic_json{ { "id", 1 } } };
+        ASSERT_EQ(basic_json::diff(records, moved), (basic_json::array_t{
+            basic_json{ { "op", "remove" }, { "path", "/0" } },
+            basic_json{ { "op", "add" }, { "path", "/2" }, { "value", basic_json{ { "id", 1 } } } },
+        }));
+    }
+
+    TEST(BasicJsonTests, ApplyPatch) {
+        basic_json document{
+            { "foo", basic_json{ { "bar", "baz" }, { "waldo", "fred" } } },
+            { "qux", basic_json{ { "corge", "grault" } } },
+        };
+
+        ASSERT_TRUE(document.apply_patch(basic_json::array_t{
+            basic_json{ { "op", "move" }, { "from", "/foo/waldo" }, { "path", "/qux/thud" } },
+            basic_json{ { "op", "copy" }, { "from", "/foo/bar" }, { "path", "/qux/values" } },
+            basic_json{ { "op", "replace" }, { "path", "/qux/values" }, { "value", basic_json::array_t{ 1, 3 } } },
+            basic_json{ { "op", "add" }, { "path", "/qux/values/1" }, { "value", 2 } },
+            basic_json{ { "op", "add" }, { "path", "/qux/values/-" }, { "value", 4 } },
+            basic_json{ { "op", "test" }, { "path", "/qux/values/3" }, { "value", 4 } },
+        }));
+
+        basic_json expected{
+            { "foo", basic_json{ { "bar", "baz" } } },
+            { "qux", basic_json{ { "corge", "grault" }, { "thud", "fred" }, { "values", basic_json::array_t{ 1, 2, 3, 4 } } } },
+        };
+
+        ASSERT_EQ(document, expected);
+        ASSERT_FALSE(document.is_shared());
+
+        auto& bar = document["foo"]["bar"];
+        ASSERT_FALSE(document.apply_patch(basic_json::array_t{
+            basic_json{ { "op", "remove" }, { "path", "/foo/bar" } },
+            basic_json{ { "op", "test" }, { "path", "/qux/corge" }, { "value", "nope" } },
+        }));
+
+        ASSERT_EQ(document, expected);
+        ASSERT_FALSE(document.is_shared());
+        ASSERT_EQ(&document["foo"]["bar"], &bar); // Untouched by the failed patch
+
+        basic_json reordered{ { "thud", "fred" }, { "corge", "grault" }, { "values", basic_json::array_t{ 1, 2, 3, 4 } } };
+        ASSERT_TRUE(document.apply_patch(basic_json::array_t{
+            basic_json{ { "op", "test" }, { "path", "/qux" }, { "value", reordered } },
+        }));
+        ASSERT_FALSE(document.is_shared());
+    }
+
+    // ------------------------------------------------
+
+    TEST(BasicJsonTests, ParseRootValues) {
+        // Bracketed arrays and single values are not taken for a root object without braces
+        ASSERT_EQ(basic_json::parse("[1, 2]").value(), (basic_json::array_t{ 1, 2 }));
+        ASSERT_EQ(basic_json::parse("1").value(), 1);
+        ASSERT_EQ(basic_json::parse(" \"a\" ").value(), "a");
+        ASSERT_EQ(basic_json::parse("a").value(), "a");
+        ASSERT_EQ(basic_json::parse("1 // one").value(), 1);
+    }
+
+    TEST(BasicJsonTests, ParseRootWithoutBraces) {
+        // An object without braces must start with a key followed by ':'
+        ASSERT_EQ(basic_json::parse("a: 1\nb: 2").value(), (basic_json{ { "a", 1 }, { "b", 2 } }));
+        ASSERT_EQ(basic_json::parse("\"a\": 1").value(), (basic_json{ { "a", 1 } }));
+
+        // An array without brackets needs at least 2 elements, otherwise it is the value itself
+        ASSERT_EQ(basic_json::parse("1, 2").value(), (basic_json::array_t{ 1, 2 }));
+        ASSERT_EQ(basic_json::parse("{ \"a\": 1 }").value(), (basic_json{ { "a", 1 } }));
+    }
+
+    TEST(BasicJsonTests, ParseRootTrailingInput) {
+        ASSERT_FALSE(basic_json::parse("{} }").has_value());
+        ASSERT_FALSE(basic_json::parse("[1] x").has_value());
+        ASSERT_FALSE(basic_json::parse("{ \"a\": 1 } [").has_value());
+        ASSERT_TRUE(basic_json::parse("[1] /* trailing comment */ ").has_value());
+    }
+
+    TEST(BasicJsonTests, NestingDepth) {
+        ASSERT_FALSE(basic_json::parse(std::string(100000, '[')).has_value());
+        ASSERT_FALSE(basic_json::parse(std::string(11, '[') + std::string(11, ']'), { .max_depth = 10 }).has_value());
+
+        std::string nested = std::string(100, '[') + std::string(100, ']');
+        auto result = basic_json::parse(nested);
+        ASSERT_TRUE(result.has_value());
+        ASSERT_EQ(result->to_string(), nested);
+
+        // Strict json is parsed without recursion, so only max_depth limits it
+        std::string deepText = std::string(100000, '[') + std::string(100000, ']');
+        auto deepResult = basic_json::parse(deepText, { .max_depth = 100001 });
+        ASSERT_TRUE(deepResult.has_value());
+        ASSERT_EQ(deepResult->to_string(), deepText);
+
+        // Anything else goes to the recursive parser, which keeps its own limit
+        ASSERT_FALSE(basic_json::parse(std::string(100000, '['), { .max_depth = 100001 }).has_value());
+        ASSERT_FALSE(basic_json::parse(deepText + " // comment", { .max_depth = 100001 }).has_value());
+        std::string hjsonText = std::string(300, '[') + "a\n" + std::string(300, ']');
+        ASSERT_FALSE(basic_json::parse(hjsonText, { .max_depth = 100001 }).has_value());
+        ASSERT_TRUE(basic_json::parse(hjsonText, { .max_depth = 100001, .max_recursive_depth = 301 }).has_value());
+
+        // Same document from the explicit stack and from the recursive parser, which hjson needs
+        std::string text = R"({"a": [1, 2.5, {"b": null}], "c": "d", "a": true, "e": {}})";
+        auto strict = basic_json::parse(text).value();
+        ASSERT_EQ(strict, basic_json::parse(text + " // comment").value());
+        ASSERT_EQ(strict.to_string(), R"({"c":"d","a":true,"e":{}})");
+
+        basic_json deep;
+        basic_json* node = &deep;
+        for (std::size_t i = 0; i < 100000; ++i) node = &node->push_back(basic_json::array_t{});
+        ASSERT_EQ(deep.to_string().size(), 200002);
+        ASSERT_EQ(deep.serialized_size(), 200002);
+        std::string deepBuffer(200002, '\0');
+        ASSERT_EQ(deep.serialize_to(deepBuffer.data(), deepBuffer.data() + deepBuffer.size()).ec, std::errc{});
+        ASSERT_EQ(deepBuffer, deep.to_string());
+
+        std::size_t values = 0;
+        node->push_back(1);
+        deep.forall([&](auto&) { ++values; });
+        ASSERT_EQ(values, 1);
+    }
+
+#if BASIC_JSON_PARSER_STATS
+
+    TEST(BasicJsonTests, ParserStats) {
+        using production = basic_json::parser::production;
+
+        auto result = basic_json::parse(R"~~({ "a": [1, 2, 3], b: quoteless, "c": { "d": "a string that is too long for small string optimization" } })~~");
+        ASSERT_TRUE(result.has_value());
+
+        auto& stats = result.stats();
+        ASSERT_GE(stats[production::object], 2);
+        ASSERT_EQ(stats[production::member], 4);
+        ASSERT_EQ(stats.nodes[basic_json::object], 2);
+        ASSERT_EQ(stats.nodes[basic_json::array], 1);
+        ASSERT_EQ(stats.nodes[basic_json::number], 3);
+        ASSERT_EQ(stats.allocations[basic_json::object], 4);
+        ASSERT_GE(stats.allocations[basic_json::string], 1);
+        ASSERT_EQ(stats.max_depth, 2);
+        ASSERT_GT(stats.backtracks, 0);
+        ASSERT_GE(stats.bytes_consumed, 105); // Every byte at least once
+    }
+
+#else
+
+    // Without statistics the parser and its results carry nothing extra
+    struct result_without_stats {
+        std::vector<basic_json::parser::error> errors;
+        std::optional<basic_json> value;
+    };
+
+    static_assert(sizeof(basic_json::parser::result<basic_json>) == sizeof(result_without_stats));
+
+#endif
+
+    TEST(BasicJsonTests, Unicode) {
+        ASSERT_EQ(basic_json::parse(R"~~("\u00e9")~~").value(), "\xC3\xA9");
+        ASSERT_EQ(basic_json::parse(R"~~("\ud83d\ude00")~~").value(), "\xF0\x9F\x98\x80");
+
+        auto lone = basic_json::parse(R"~~("\ud83d x")~~");
+        ASSERT_TRUE(lone.has_value());
+        ASSERT_EQ(lone.value(), "\xEF\xBF\xBD x");
+        ASSERT_FALSE(lone.errors().empty());
+
+        ASSERT_FALSE(basic_json::parse(R"~~("\u12")~~").has_value());
+        ASSERT_FALSE(basic_json::parse("\"\xC3\x28\"").has_value());
+        ASSERT_TRUE(basic_json::parse("\"\xC3\x28\"", { .validate_utf8 = false }).has_value());
+        ASSERT_FALSE(basic_json::parse("[1, // caf\xC3\n 2]").has_value());
+        ASSERT_FALSE(basic_json::parse("/* \xFF */ [1, 2]").has_value());
+        ASSERT_FALSE(basic_json::table::shred("/* \xFF */ [{ \"a\": 1 }]").has_value());
+        ASSERT_TRUE(basic_json::parse("[1, // caf\xC3\n 2]", { .validate_utf8 = false }).has_value());
+
+        auto quoteless = basic_json::parse("{\n  a: x\xFFy\n}");
+        ASSERT_FALSE(quoteless.has_value());
+        auto invalid = std::ranges::find_if(quoteless.errors(), [](auto& error) { return error.message.message == "Invalid UTF-8 sequence"; });
+        ASSERT_NE(invalid, quoteless.errors().end());
+        ASSERT_EQ(invalid->line, 2);
+        ASSERT_EQ(invalid->character, 7);
+
+        ASSERT_TRUE(basic_json::validate_utf8("ascii \xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80"));
+        ASSERT_FALSE(basic_json::validate_utf8("\xC0\xAF"));         // Overlong
+        ASSERT_FALSE(basic_json::validate_utf8("\xED\xA0\x80"));     // Surrogate
+        ASSERT_FALSE(basic_json::validate_utf8("\xF4\x90\x80\x80")); // Above U+10FFFF
+        ASSERT_FALSE(basic_json::validate_utf8("\xE2\x82"));         // Truncated
+        ASSERT_EQ(basic_json::find_invalid_utf8(std::string(40, 'a') + "\xFF"), 40);
+
+        basic_json json = std::string{ "\xC3\xA9\xF0\x9F\x98\x80\x01" };
+        ASSERT_EQ(json.to_string(), "\"\xC3\xA9\xF0\x9F\x98\x80\\u0001\"");
+        ASSERT_EQ(json.to_ascii_string(), R"~~("\u00e9\ud83d\ude00\u0001")~~");
+        ASSERT_EQ(basic_json::parse(json.to_ascii_string()).value(), json);
+    }
+
+    TEST(BasicJsonTests, ParallelParse) {
+        std::string text = "[ // comment, with ] brackets\n";
+        for (std::size_t i = 0; i < 1000; ++i) {
+            if (i != 0) text += i % 10 ? ",\n" : ", /* [ { */ ";
+            switch (i % 5) {
+            case 0: text += std::to_string(i); break;
+            case 1: text += "\"str,ing ] \\\" " + std::to_string(i) + "\""; break;
+            case 2: text += "{ \"a\": [1, 2.5e3, { \"b\": null }], \"c\": 'x]' }"; break;
+            case 3: text += "[true, false]"; break;
+            case 4: text += "-0.5"; break;
+            }
+        }
+        text += "\n] # done";
+
+        basic_json::parser::parse_options parallel{ .threads = 4, .parallel_min_size = 0 };
+        auto sequential = basic_json::parse(text);
+        auto result = basic_json::parse(text, parallel);
+        ASSERT_TRUE(sequential.has_value());
+        ASSERT_TRUE(result.has_value());
+        ASSERT_EQ(result->size(), 1000);
+        ASSERT_EQ(result.value(), sequential.value());
+
+        // Warnings from the parts point to the same place in the whole text
+        std::string warned = text;
+        warned.insert(warned.rfind("-0.5"), "\"\\ud800\", ");
+        auto expectedWarnings = basic_json::parse(warned);
+        auto actualWarnings = basic_json::parse(warned, parallel);
+        ASSERT_TRUE(actualWarnings.has_value());
+        ASSERT_FALSE(expectedWarnings.errors().empty());
+        ASSERT_EQ(actualWarnings.errors().size(), expectedWarnings.errors().size());
+        for (std::size_t i = 0; i < expectedWarnings.errors().size(); ++i) {
+            ASSERT_EQ(actualWarnings.errors()[i].line, expectedWarnings.errors()[i].line);
+            ASSERT_EQ(actualWarnings.errors()[i].character, expectedWarnings.errors()[i].character);
+        }
+
+        // Falls back to sequential parsing, with identical results and errors
+        for (std::string_view input : { "[a, b c, 1]", "[1,,2, 3]", "[1, 2, 3] x", "[1, '''\nx\n''', 3]" }) {
+            auto expected = basic_json::parse(input);
+            auto actual = basic_json::parse(input, parallel);
+            ASSERT_EQ(actual.has_value(), expected.has_value());
+            if (expected.has_value()) {
+                ASSERT_EQ(actual.value(), expected.value());
+            }
+            ASSERT_EQ(actual.errors().size(), expected.errors().size());
+        }
+    }
+
+    TEST(BasicJsonTests, ParallelSerialize) {
+        basic_json json;
+        auto& large = json["large"];
+        for (std::size_t i = 0; i < 1000; ++i) {
+            large.push_back(basic_json{ { "index", i }, { "name", "element " + std::to_string(i) }, { "values", basic_json::array_t{ 1, 2.5, nullptr } } });
+        }
+        for (std::size_t i = 0; i < 100; ++i) json["wide"]["key" + std::to_string(i)] = "value\n" + std::to_string(i);
+        json["small"] = basic_json::array_t{ true, false };
+
+        basic_json::serializer::options options{ .threads = 4, .parallel_min_size = 10 };
+        ASSERT_EQ(json.to_string(options), json.to_string());
+
+        options.hjson = true;
+        ASSERT_EQ(json.to_string(options), json.to_hjson_string());
+
+        options.threads = 16;
+        options.parallel_min_size = 0;
+        ASSERT_EQ(json.to_string(options), json.to_hjson_string());
+        basic_json empty = basic_json::array_t{};
+        ASSERT_EQ(empty.to_string(options), "[]");
+    }
+
+    // In-process pipe, reading suspends until something is written or the pipe is closed
+    struct fake_pipe {
+        std::deque<std::string> pending;
+        std::string current;
+        std::coroutine_handle<> reader;
+        bool closed = false;
+
+        auto read() {
+            struct awaiter {
+                fake_pipe& pipe;
+                bool await_ready() const { return !pipe.pending.empty() || pipe.closed; }
+                void await_suspend(std::coroutine_handle<> handle) { pipe.reader = handle; }
+                std::string_view await_resume() {
+                    if (pipe.pending.empty()) return {};
+                    pipe.current = std::move(pipe.pending.front());
+                    pipe.pending.pop_front();
+                    return pipe.current;
+                }
+            };
+            return awaiter{ *this };
+        }
+
+        void write(std::string data) { pending.push_back(std::move(data)), wake(); }
+        void close() { closed = true, wake(); }
+        void wake() { if (auto handle = std::exchange(reader, {})) handle.resume(); }
+    };
+
+    TEST(BasicJsonTests, IncrementalParse) {
+        std::string text = "# numbers\n[1, \"two, ]\", { \"three\": [3] }, /* four */ 4.0, true,\n]";
+        basic_json::incremental_parser parser;
+        for (char c : text) parser.feed(std::string_view{ &c, 1 });
+        auto result = parser.finish();
+        ASSERT_TRUE(result.has_value());
+        ASSERT_EQ(result.value(), basic_json::parse(text).value());
+
+        // Anything but a root array is parsed at once by finish
+        for (std::string_view input : { "a: 1\nb: [2]", "[1, quoteless]", "[1,,2]", "[1] 2", "" }) {
+            basic_json::incremental_parser other;
+            other.feed(input.substr(0, input.size() / 2));
+            other.feed(input.substr(input.size() / 2));
+            auto expected = basic_json::parse(input);
+            auto actual = other.finish();
+            ASSERT_EQ(actual.has_value(), expected.has_value());
+            if (expected.has_value()) {
+                ASSERT_EQ(actual.value(), expected.value());
+            }
+        }
+    }
+
+    TEST(BasicJsonTests, AsyncParse) {
+        fake_pipe pipe;
+        auto task = basic_json::parse_async(pipe);
+        task.start();
+
+        pipe.write("{ \"a\": [1, ");
+        pipe.write("2] ");
+        ASSERT_FALSE(task.done());
+        pipe.write("}");
+        pipe.close();
+
+        ASSERT_TRUE(task.done());
+        ASSERT_TRUE(task.get().has_value());
+        ASSERT_EQ(task.get().value(), (basic_json{ { "a", basic_json::array_t{ 1, 2 } } }));
+    }
+
+    TEST(BasicJsonTests, SerializeChunks) {
+        basic_json json;
+        for (std::size_t i = 0; i < 100; ++i) json["key" + std::to_string(i)] = basic_json::array_t{ i, "value", nullptr };
+
+        std::string result;
+        std::size_t chunks = 0;
+        json["long"] = std::string(1000, 'x'); // Split over many chunks
+        std::string expected = json.to_string();
+        for (std::string_view chunk : json.to_string_chunks(64)) {
+            ASSERT_EQ(chunk.size(), std::min<std::size_t>(64, expected.size() - result.size()));
+            result += chunk;
+            ++chunks;
+        }
+
+        ASSERT_EQ(result, expected);
+        ASSERT_EQ(chunks, (expected.size() + 63) / 64);
+
+        std::size_t single = 0;
+        basic_json small = "abc";
+        for (std::string_view chunk : small.to_string_chunks(0)) {
+            ASSERT_EQ(chunk.size(), 1);
+            ++single;
+        }
+        ASSERT_EQ(single, 5);
+    }
+
+    TEST(BasicJsonTests, SchemaValidation) {
+        basic_json::schema schema{ basic_json::parse(R"~~({
+            "type": "object",
+            "required": ["name", "tags"],
+            "properties": {
+                "name": { "type": "string", "maxLength": 4 },
+                "age": { "type": "integer", "minimum": 0, "maximum": 150 },
+                "kind": { "enum": ["a", "b"] },
+                "tags": { "type": "array", "maxItems": 3, "items": { "type": "string" } }
+            },
+            "additionalProperties": false
+        })~~").value() };
+
+        auto parse = [&](std::string_view json) { return basic_json::parse(json, { .schema = &schema }); };
+        auto rejects = [&](std::string_view json, std::string_view message) {
+            auto result = parse(json);
+            return !result.has_value() && std::ranges::any_of(result.errors(), [&](auto& error) { return error.message.message == message; });
+        };
+
+        ASSERT_TRUE(parse(R"~~({ "name": "\u00e9t\u00e9", "age": 30, "kind": "a", "tags": ["x", "y"] })~~").has_value());
+        ASSERT_TRUE(rejects(R"~~({ "name": "abcde", "tags": [] })~~", "String length is out of the range allowed by the schema"));
+        ASSERT_TRUE(rejects(R"~~({ "name": "a", "age": 1.5, "tags": [] })~~", "Value does not match the type in the schema"));
+        ASSERT_TRUE(rejects(R"~~({ "name": "a", "age": -1, "tags": [] })~~", "Number is out of the range allowed by the schema"));
+        ASSERT_TRUE(rejects(R"~~({ "name": "a", "kind": "c", "tags": [] })~~", "Value is not one of the values allowed by the schema"));
+        ASSERT_TRUE(rejects(R"~~({ "name": "a", "tags": [1] })~~", "Value does not match the type in the schema"));
+        ASSERT_TRUE(rejects(R"~~({ "name": "a", "tags": ["1", "2", "3", "4"] })~~", "Array size is out of the range allowed by the schema"));
+        ASSERT_TRUE(rejects(R"~~({ "name": "a" })~~", "Object is missing a property required by the schema"));
+        ASSERT_TRUE(rejects(R"~~({ "name": "a", "other": 1, "tags": [] })~~", "Property is not allowed by the schema"));
+        ASSERT_TRUE(rejects(R"~~([1, 2])~~", "Value does not match the type in the schema"));
+
+        // Rejected at the violation, before the rest of the input is parsed
+        ASSERT_TRUE(rejects(R"~~({ "name": "a", "other": [ this is not valid json)~~", "Property is not allowed by the schema"));
+
+        basic_json valid = basic_json::parse(R"~~({ "name": "a", "tags": ["b"] })~~").value();
+        ASSERT_TRUE(schema.matches(valid));
+        valid["age"] = 200;
+        ASSERT_EQ(schema.violation(valid), "Number is out of the range allowed by the schema");
+
+        basic_json::schema numbers{ basic_json::parse(R"~~({ "items": { "type": "number", "exclusiveMaximum": 10 } })~~").value() };
+        ASSERT_TRUE(basic_json::parse("[1, 2, 3]", { .threads = 4, .parallel_min_size = 0, .schema = &numbers }).has_value());
+        ASSERT_FALSE(basic_json::parse("[1, 2, 10]", { .threads = 4, .parallel_min_size = 0, .schema = &numbers }).has_value());
+        ASSERT_THROW(basic_json::schema{ basic_json{ 1 } }, std::runtime_error);
+
+        // Without brackets the items only apply once the root turns out to be an array
+        basic_json::schema list{ basic_json::parse(R"~~({ "type": ["array", "string"], "items": { "type": "number" } })~~").value() };
+        ASSERT_EQ(basic_json::parse("abc", { .schema = &list }).value(), "abc");
+        ASSERT_EQ(basic_json::parse("1\n2", { .schema = &list }).value(), basic_json::parse("[1, 2]").value());
+        ASSERT_FALSE(basic_json::parse("1\nb", { .schema = &list }).has_value());
+        ASSERT_FALSE(basic_json::parse("[\"abc\"]", { .schema = &list }).has_value());
+    }
+
+    TEST(BasicJsonTests, ParseInto) {
+        std::string document = R"~~({ "name": "a string that is too long for small string optimization", "values": [1, 2.5, -3], "nested": { "a": true } })~~";
+        basic_json target;
+        ASSERT_TRUE(basic_json::parse_into(target, document).has_value());
+        ASSERT_EQ(target, basic_json::parse(document).value());
+
+        // Same shape again, the storage of the previous document is reused
+        const char* name = target["name"].as<std::string_view>().data();
+        const basic_json* values = target["values"].as<basic_json::array_t>().data();
+        ASSERT_TRUE(basic_json::parse_into(target, document).has_value());
+        ASSERT_EQ(target, basic_json::parse(document).value());
+        ASSERT_EQ(target["name"].as<std::string_view>().data(), name);
+        ASSERT_EQ(target["values"].as<basic_json::array_t>().data(), values);
+
+        // Short keys and strings fit in the small string buffer, and leave the recycled one to the long string
+        std::string shorter = R"~~({ "k": "x", "y": "another string too long for small string optimization" })~~";
+        name = target["name"].as<std::string_view>().data();
+        ASSERT_TRUE(basic_json::parse_into(target, shorter).has_value());
+        ASSERT_EQ(target, basic_json::parse(shorter).value());
+        ASSERT_EQ(target["y"].as<std::string_view>().data(), name);
+
+        std::string other = R"~~([{ "a": 1, "a": 2 }, "x", [], 1e3])~~";
+        ASSERT_TRUE(basic_json::parse_into(target, other).has_value());
+        ASSERT_EQ(target, basic_json::parse(other).value());
+
+        auto failed = basic_json::parse_into(target, R"~~({ "a": )~~");
+        ASSERT_FALSE(failed.has_value());
+        ASSERT_FALSE(failed.errors().empty());
+        ASSERT_TRUE(target.is(basic_json::null));
+    }
+
+    TEST(BasicJsonTests, BulkConstruction) {
+        basic_json arr;
+        arr.reserve(100);
+        ASSERT_TRUE(arr.is(basic_json::array));
+        arr.append_range(std::views::iota(0, 100));
+        ASSERT_EQ(arr.size(), 100);
+        ASSERT_EQ(arr[99], 99);
+
+        std::vector<std::string> front{ "a", "b" };
+        auto inserted = arr.insert_range(arr.as<basic_json::array_t>().begin() + 1, front);
+        ASSERT_EQ(inserted - arr.as<basic_json::array_t>().begin(), 1);
+        ASSERT_EQ(arr.size(), 102);
+        ASSERT_EQ(arr[0], 0);
+        ASSERT_EQ(arr[1], "a");
+        ASSERT_EQ(arr[2], "b");
+        ASSERT_EQ(arr[3], 1);
+
+        basic_json obj;
+        std::vector<std::pair<std::string, int>> members;
+        for (int i = 0; i < 1000; ++i) members.emplace_back("key" + std::to_string(i), i);
+        obj.append_range(members);
+        ASSERT_EQ(obj.size(), 1000);
+        ASSERT_EQ(obj["key500"], 500);
+
+        // Existing keys keep their position, like put
+        std::map<std::string, std::string> replace{ { "key0", "zero" }, { "new", "value" } };
+        obj.append_range(replace);
+        ASSERT_EQ(obj.size(), 1001);
+        ASSERT_EQ(obj.as<basic_json::object_t>().front().second, "zero");
+        ASSERT_EQ(obj.as<basic_json::object_t>().back().first, "new");
+
+        // Without a known size, repeated keys are still found once the object grew
+        std::vector<std::pair<std::string, int>> repeated;
+        for (int i = 0; i < 40; ++i) repeated.emplace_back("key" + std::to_string(i % 20), i);
+        basic_json unsized;
+        unsized.append_range(repeated | std::views::filter([](auto&) { return true; }));
+        ASSERT_EQ(unsized.size(), 20);
+        ASSERT_EQ(unsized["key5"], 25);
+        ASSERT_EQ(unsized["key19"], 39);
+
+        obj.emplace("emplaced", basic_json::array_t{ 1, 2 });
+        ASSERT_EQ(obj.as<basic_json::object_t>().back().first, "emplaced");
+        ASSERT_THROW(arr.emplace("key", 1), std::runtime_error);
+    }
+
+    TEST(BasicJsonTests, Ranges) {
+        basic_json json = basic_json::parse(R"~~({ "values": [1, "a", 2.5, true, 4], "b": null })~~").value();
+
+        std::vector<std::string> keys;
+        for (auto& [key, val] : json.items()) keys.push_back(key);
+        ASSERT_EQ(keys, (std::vector<std::string>{ "values", "b" }));
+        ASSERT_TRUE(json["b"].items().empty());
+        ASSERT_TRUE(json.elements().empty());
+
+        auto& values = json["values"];
+        ASSERT_EQ(values.elements().size(), 5);
+        ASSERT_EQ(std::ranges::count_if(values.elements(), [](auto& val) { return val.is(basic_json::number); }), 3);
+
+        auto numbers = values.as_range<double>();
+        ASSERT_EQ(std::ranges::distance(numbers), 3);
+        ASSERT_EQ(*std::ranges::max_element(numbers), 4);
+
+        auto large = values.as_range<double>() | std::views::filter([](double val) { return val > 2; }) | std::views::take(1);
+        ASSERT_EQ(*large.begin(), 2.5);
+
+        for (auto& val : values.elements()) if (val.is(basic_json::number)) val = 0;
+        ASSERT_EQ(values[0], 0);
+
+        std::array<int, 2> first{};
+        ASSERT_TRUE(values.try_get(first));
+        ASSERT_EQ(first[1], 0);
+        std::vector<std::string> strings;
+        ASSERT_TRUE(values.try_get(strings));
+        ASSERT_EQ(strings, std::vector<std::string>{ "a" });
+    }
+
+    TEST(BasicJsonTests, PackedArrays) {
+        std::string text = "[";
+        for (int i = 0; i < 100; ++i) text += (i ? ", " : "") + std::to_string(i) + ".5";
+        text += "]";
+
+        auto packed = basic_json::parse(text, { .pack_numbers = true }).value();
+        auto unpacked = basic_json::parse(text).value();
+        ASSERT_TRUE(packed.is_packed<double>());
+        ASSERT_FALSE(unpacked.is_packed());
+        ASSERT_TRUE(packed.is(basic_json::array));
+        ASSERT_EQ(packed.size(), 100);
+        ASSERT_EQ(packed, unpacked);
+        ASSERT_EQ(packed.hash(), unpacked.hash());
+        ASSERT_EQ(packed.to_string(), unpacked.to_string());
+
+        ASSERT_EQ(packed.as_span<double>()[3], 3.5);
+        ASSERT_EQ(packed.sum(), 5000);
+        ASSERT_EQ(unpacked.sum(), 5000);
+        ASSERT_EQ(packed.minimum(), 0.5);
+        ASSERT_EQ(packed.maximum(), 99.5);
+        ASSERT_EQ(unpacked.maximum(), 99.5);
+
+        const basic_json& view = packed;
+        const basic_json& element = view[1];
+        ASSERT_EQ(element, 1.5);
+        ASSERT_TRUE(packed.is_packed()); // Const access does not unpack
+
+        packed.scale(2);
+        ASSERT_EQ(element, 3); // Still valid, scaled along
+        packed.append_range(std::vector<double>{ 1.0 });
+        ASSERT_TRUE(packed.is_packed<double>());
+        ASSERT_EQ(packed.sum(), 10001);
+
+        packed.push_back("not a number");
+        ASSERT_FALSE(packed.is_packed());
+        ASSERT_EQ(packed.size(), 102);
+        ASSERT_EQ(packed[1], 3);
+        ASSERT_THROW(packed.as_span<double>(), std::runtime_error);
+
+        std::string integers = "[";
+        for (int i = 0; i < 20; ++i) integers += (i ? ", " : "") + std::to_string(i % 2 ? -i : i);
+        auto pack = [](std::string_view json) { return basic_json::parse(json, { .pack_numbers = true }).value(); };
+        ASSERT_TRUE(pack(integers + "]").is_packed<std::int64_t>());
+        ASSERT_TRUE(pack(integers + ", 18446744073709551615]").is(basic_json::array));
+        ASSERT_FALSE(pack(integers + ", 18446744073709551615]").is_packed());
+        ASSERT_FALSE(pack(integers + ", 0.5]").is_packed());
+        ASSERT_FALSE(basic_json::parse(integers + "]").value().is_packed()); // Not packed by default
+
+        basic_json built = basic_json::array_t{ 1u, 2u, 3u };
+        ASSERT_TRUE(built.pack());
+        ASSERT_EQ(built.as_span<std::uint64_t>().size(), 3);
+        ASSERT_EQ(built.to_string(), "[1,2,3]");
+    }
+
+    static_assert(!basic_json::literal_parser::parse(R"({ "a": [1, -2, 3.5e1, "\u00e9\ud83d\ude00"], "b": null })").error);
+    static_assert(basic_json::literal_parser::parse(R"({ "a": 1, })").error);
+    static_assert(basic_json::literal_parser::parse(R"([1, 2)").error);
+    static_assert(basic_json::literal_parser::parse(R"("\ud83d")").error);
+    static_assert(basic_json::literal_parser::parse("01").error);
+    static_assert(basic_json::literal_parser::parse("").error);
+
+    TEST(BasicJsonTests, JsonLiteral) {
+        constexpr auto literal = R"({
+            "name": "literal",
+            "values": [1, -2, 3.5, 18446744073709551616, true, null],
+            "text": "tab\t\u00e9\ud83d\ude00"
+        })"_json;
+
+        const basic_json& json = literal;
+        ASSERT_EQ(json, basic_json::parse(R"({
+            "name": "literal",
+            "values": [1, -2, 3.5, 18446744073709551616, true, null],
+            "text": "tab\t\u00e9\ud83d\ude00"
+        })").value());
+        ASSERT_EQ(json["values"][1].as<std::int64_t>(), -2);
+        ASSERT_EQ(json["values"][3].as<double>(), 18446744073709551616.0); // Too large for an integer, as at runtime
+        ASSERT_EQ(json["text"], "tab\t\xC3\xA9\xF0\x9F\x98\x80");
+        ASSERT_EQ(&literal.value(), &json); // Built once
+
+        basic_json copy = R"([1, 2, 3])"_json;
+        copy.push_back(4);
+        ASSERT_EQ(copy.size(), 4);
+        ASSERT_EQ((*R"([1, 2, 3])"_json).size(), 3);
+    }
+
+    TEST(BasicJsonTests, PrettyPrint) {
+        const basic_json json = basic_json::parse(R"({ "a": [1, 2, 3], "b": [{ "c": "d" }, []], "e": {} })").value();
+
+        ASSERT_EQ(json.to_pretty_string(), 
+            "{\n"
+            "  \"a\": [1,2,3],\n"
+            "  \"b\": [\n"
+            "    {\n"
+            "      \"c\": \"d\"\n"
+            "    },\n"
+            "    []\n"
+            "  ],\n"
+            "  \"e\": {}\n"
+            "}");
+
+        ASSERT_EQ(json.to_pretty_string({ .tabs = true, .max_width = 24 }),
+            "{\n"
+            "\t\"a\": [1,2,3],\n"
+            "\t\"b\": [{\"c\":\"d\"},[]],\n"
+            "\t\"e\": {}\n"
+            "}");
+
+        ASSERT_EQ(json.to_pretty_string({ .max_width = 14, .hjson = true }),
+            "{\n"
+            "  a: [1,2,3]\n"
+            "  b: [\n"
+            "    {c:\"d\"}\n"
+            "    []\n"
+            "  ]\n"
+            "  e: {}\n"
+            "}");
+
+        ASSERT_EQ(json.to_pretty_string({ .max_width = 100 }), json.to_string());
+        ASSERT_EQ(basic_json::parse(json.to_pretty_string({ .max_width = 10 })).value(), json);
+        ASSERT_EQ(basic_json::parse(json.to_pretty_string({ .max_width = 10, .hjson = true })).value(), json);
+    }
+
+    TEST(BasicJsonTests, HjsonKeys) {
+        basic_json json{ { "plain", 1 }, { "a b", 2 }, { "x:y", 3 }, { "#c", 4 }, { "//d", 5 }, { "it's", 6 }, { "line\nbreak", 7 }, { "[e]", 8 } };
+        std::string hjson = json.to_hjson_string();
+        ASSERT_EQ(basic_json::parse(hjson).value(), json);
+        ASSERT_EQ(basic_json::parse(json.to_pretty_string({ .max_width = 10, .hjson = true })).value(), json);
+        ASSERT_TRUE(hjson.contains("plain:1"));
+        ASSERT_TRUE(hjson.contains("\"a b\":2"));
+        ASSERT_TRUE(hjson.contains("\"#c\":4"));
+
+        basic_json empty{ { "", 1 } };
+        ASSERT_EQ(empty.to_hjson_string(), "{\"\":1}");
+    }
+
+    TEST(BasicJsonTests, SerializeToBuffer) {
+        std::string text = R"({"name":"caf\u00e9","values":[1,-2,0.5,1e+300,true,null],"nested":{"a":[]}})";
+        auto json = basic_json::parse(text).value();
+        json["packed"] = basic_json::array_t{ 1.5, 2.5 };
+        ASSERT_TRUE(json["packed"].pack());
+
+        for (auto settings : { basic_json::serializer::options{}, { .hjson = true }, { .ascii_only = true } }) {
+            std::string expected = json.to_string(settings);
+            ASSERT_EQ(json.serialized_size(settings), expected.size());
+
+            std::string buffer(expected.size(), '\0');
+            auto [ptr, ec] = json.serialize_to(buffer.data(), buffer.data() + buffer.size(), settings);
+            ASSERT_EQ(ec, std::errc{});
+            ASSERT_EQ(ptr, buffer.data() + buffer.size());
+            ASSERT_EQ(buffer, expected);
+
+            auto small = json.serialize_to(buffer.data(), buffer.data() + buffer.size() - 1, settings);
+            ASSERT_EQ(small.ec, std::errc::value_too_large);
+        }
+
+        ASSERT_EQ(basic_json(1.5e20).to_string(), "1.5e+20"); // Exponent zeros are kept
+    }
+
+    TEST(BasicJsonTests, DocumentStore) {
+        basic_json::store config{ basic_json::parse(R"({ "version": 0 })").value() };
+
+        auto first = config.load();
+        ASSERT_EQ(first.version(), 0);
+        ASSERT_EQ((*first)["version"], 0);
+
+        ASSERT_EQ(config.publish(basic_json::parse(R"({ "version": 1 })").value()), 1);
+        ASSERT_EQ((*first)["version"], 0); // Old version stays alive for the snapshot
+        ASSERT_EQ(config.pending(), 1);
+        ASSERT_EQ((*config.load())["version"], 1);
+
+        first = config.load();
+        config.publish(basic_json::parse(R"({ "version": 2 })").value());
+        ASSERT_EQ(config.pending(), 1); // Version 0 deleted, version 1 still used
+
+        std::atomic<bool> stop = false;
+        std::atomic<std::size_t> failures = 0;
+        std::vector<std::jthread> readers;
+        for (std::size_t i = 0; i < 8; ++i) readers.emplace_back([&] {
+            while (!stop.load()) {
+                auto snapshot = config.load();
+                if ((*snapshot)["version"].as<std::uint64_t>() != snapshot.version()) ++failures;
+            }
+        });
+
+        for (std::uint64_t i = 3; i < 200; ++i) config.publish(basic_json{ { "version", i } });
+        stop = true;
+        readers.clear();
+
+        ASSERT_EQ(failures, 0);
+        ASSERT_EQ(config.load().version(), 199);
+        first = config.load();
+        config.publish(nullptr);
+        ASSERT_EQ(config.pending(), 1);
+        first = config.load(); // Releasing the last snapshot of a version deletes it
+        ASSERT_EQ(config.pending(), 0);
+
+        // More snapshots than slots get slots of their own
+        basic_json::store small{ basic_json{ 1 }, 2 };
+        std::vector<basic_json::store::snapshot> held;
+        for (std::size_t i = 0; i < 5; ++i) held.push_back(small.load());
+        ASSERT_EQ(*held[4], 1);
+        small.publish(2);
+        ASSERT_EQ(small.pending(), 1);
+        held.clear();
+        ASSERT_EQ(small.pending(), 0);
+        ASSERT_EQ(*small.load(), 2);
+    }
+
+    TEST(BasicJsonTests, IncrementalReparse) {
+        std::string text = R"({
+            // Settings
+            "name": "editor",
+            "sizes": [10, 20, { "width": 30 }],
+            tabs: true
+        })";
+
+        basic_json::parser::source_span spans;
+        auto json = basic_json::parse(text, { .spans = &spans }).value();
+        ASSERT_EQ(spans.begin, 0);
+        ASSERT_EQ(spans.end, text.size());
+        ASSERT_EQ(spans.children.size(), 3);
+        ASSERT_EQ(text.substr(spans.children[0].begin, spans.children[0].end - spans.children[0].begin), "\"editor\"");
+        ASSERT_EQ(spans.children[1].children.size(), 3);
+
+        // Applies the edit, and checks the result against parsing everything again
+        auto edit = [&](std::string_view find, std::size_t removed, std::string_view inserted) {
+            basic_json::text_edit change{ .offset = text.find(find), .removed = removed, .inserted = inserted };
+            text.replace(change.offset, change.removed, inserted);
+            auto result = basic_json::reparse(json, spans, text, change);
+
+            basic_json::parser::source_span expectedSpans;
+            auto expected = basic_json::parse(text, { .spans = &expectedSpans });
+            EXPECT_EQ(result.has_value(), expected.has_value());
+            if (expected.has_value()) {
+                EXPECT_EQ(json, expected.value());
+                EXPECT_EQ(spans, expectedSpans);
+            }
+            return result;
+        };
+
+        auto width = edit("30", 2, "300");
+        ASSERT_TRUE(width.has_value());
+        ASSERT_EQ(*width.value(), basic_json({ { "width", 300 } })); // Only the innermost object
+        ASSERT_EQ(json["sizes"][2]["width"], 300);
+
+        ASSERT_EQ(*edit("tor", 3, "ting").value(), "editing");
+        ASSERT_EQ(edit("20", 0, "15, ").value(), &json["sizes"]);
+        ASSERT_EQ(json["sizes"].size(), 4);
+
+        ASSERT_FALSE(edit("editing", 0, "\"").has_value()); // Unbalanced quote
+        ASSERT_EQ(json["name"], "editing");
+
+        // Multiline strings are indented relative to the column they start at in the whole text
+        text = R"({
+  notes: {
+    body: '''
+          a
+           b
+          '''
+    count: 1
+  }
+})";
+        spans = {};
+        json = basic_json::parse(text, { .spans = &spans }).value();
+        ASSERT_EQ(json["notes"]["body"], "a\n b");
+        ASSERT_EQ(edit("1\n  }", 1, "2").value(), &json["notes"]);
+        ASSERT_EQ(json["notes"]["body"], "a\n b");
+        ASSERT_EQ(json["notes"]["count"], 2);
+    }
+
+    TEST(BasicJsonTests, Query) {
+        auto json = basic_json::parse(R"({
+            "events": [
+                { "level": "error", "msg": "disk full", "code": 28 },
+                { "level": "info", "msg": "started" },
+                { "level": "error", "msg": "timeout", "code": 110, "retry": { "msg": "retrying" } }
+            ],
+            "limits": { "errors": 50 }
+        })").value();
+
+        auto strings = [](const std::vector<const basic_json*>& matches) {
+            std::vector<std::string> result;
+            for (auto match : matches) result.push_back(match->as<std::string>());
+            return result;
+        };
+
+        using list = std::vector<std::string>;
+        ASSERT_EQ(strings(json.select("$.events[?(@.level=='error')].msg")), (list{ "disk full", "timeout" }));
+        ASSERT_EQ(strings(json.select("$.events[?@.code > 30 || !@.code].msg")), (list{ "started", "timeout" }));
+        ASSERT_EQ(strings(json.select("$.events[?(@.code < $.limits.errors)]['msg']")), (list{ "disk full" }));
+        ASSERT_EQ(strings(json.select("$.events[*].retry.msg")), (list{ "retrying" }));
+        ASSERT_EQ(strings(json.select("$..msg")), (list{ "disk full", "started", "timeout", "retrying" }));
+        ASSERT_EQ(strings(json.select("$.events[-1].level")), (list{ "error" }));
+        ASSERT_EQ(strings(json.select("$.events[::-2].msg")), (list{ "timeout", "disk full" }));
+        ASSERT_EQ(strings(json.select("$.events[0,1].level")), (list{ "error", "info" }));
+        ASSERT_EQ(json.select("$.events[?@.retry]").size(), 1);
+        ASSERT_EQ(json.select("$.missing[*]").size(), 0);
+        ASSERT_EQ(json.select("$.limits.*")[0], &json["limits"]["errors"]); // Points into the document
+
+        ASSERT_THROW(basic_json::query{ "events" }, std::runtime_error);
+        ASSERT_THROW(basic_json::query{ "$.events[?(@.level == )]" }, std::runtime_error);
+        ASSERT_THROW(basic_json::query{ "$.events[0" }, std::runtime_error);
+
+        ASSERT_EQ(strings(json.select("$.events[0:3:9223372036854775807].level")), (list{ "error" }));
+        ASSERT_EQ(strings(json.select("$.events[::-9223372036854775808].level")), (list{ "error" }));
+
+        basic_json emoji{ { "\xF0\x9F\x98\x80", 1 } };
+        ASSERT_EQ(emoji.select(R"($['\ud83d\ude00'])").size(), 1);
+        ASSERT_THROW(basic_json::query{ R"($['\ud83d'])" }, std::runtime_error);
+        ASSERT_THROW(basic_json::query{ R"($['\ude00'])" }, std::runtime_error);
+
+        basic_json::array_t values;
+        for (int i = 0; i < 1000; ++i) values.push_back(basic_json{ { "id", i }, { "even", i % 2 == 0 } });
+        basic_json large = std::move(values);
+        basic_json::query even{ "$[?(@.even == true)].id" };
+        auto sequential = even.select(large);
+        ASSERT_EQ(sequential.size(), 500);
+        ASSERT_EQ(even.select(large, { .threads = 4, .parallel_min_size = 16 }), sequential);
+    }
+
+    TEST(BasicJsonTests, ColumnarTable) {
+        std::string text = R"([
+            { "id": 1, "name": "a", "pos": { "x": 0.5, "y": 1 } },
+            { "id": 2, "pos": { "x": 1.5, "y": -2 }, "tags": ["t"] },
+            { "id": 3, "name": null, "pos": { "x": 2, "y": 3 }, "ok": true }
+        ])";
+
+        auto records = basic_json::parse(text).value();
+        basic_json::table table{ records };
+        ASSERT_EQ(table.rows(), 3);
+        ASSERT_EQ(table.columns().size(), 6);
+
+        auto id = table.find("id");
+        ASSERT_EQ(id->type(), basic_json::table::column_type::unsigned_integer);
+        ASSERT_EQ(id->data<std::uint64_t>()[2], 3);
+
+        auto name = table.find("name");
+        ASSERT_EQ(name->type(), basic_json::table::column_type::string);
+        ASSERT_TRUE(name->valid(0));
+        ASSERT_FALSE(name->valid(1)); // Missing
+        ASSERT_FALSE(name->valid(2)); // Null
+        ASSERT_EQ(name->text()[0], "a");
+
+        ASSERT_EQ(table.find("pos.x")->type(), basic_json::table::column_type::floating_point);
+        ASSERT_EQ(table.find("pos.x")->data<double>()[2], 2.0);
+        ASSERT_EQ(table.find("pos.y")->type(), basic_json::table::column_type::signed_integer);
+        ASSERT_EQ(table.find("pos.y")->data<std::int64_t>()[1], -2);
+        ASSERT_EQ(table.find("tags")->type(), basic_json::table::column_type::json);
+        ASSERT_FALSE(table.find("ok")->valid(0)); // Added in a later row
+
+        ASSERT_EQ(table.row(1), records[1]);
+        auto last = table.row(2);
+        ASSERT_EQ(last["pos"]["x"].as<double>(), 2.0);
+        ASSERT_FALSE(last.contains("name"));
+
+        auto streamed = basic_json::table::shred(text);
+        ASSERT_TRUE(streamed.has_value());
+        ASSERT_EQ(streamed.value().to_json(), table.to_json());
+        ASSERT_FALSE(basic_json::table::shred("[{ \"a\": 1 }, { \"a\": ]").has_value());
+        ASSERT_THROW(basic_json::table{ basic_json::parse("[1, 2]").value() }, std::runtime_error);
+    }
+
+    TEST(BasicJsonTests, LazyNumbers) {
+        std::string_view text = R"({"big":123456789012345678901234567890,"price":1.50,"exp":1E+2,"neg":-0,"list":[1,2.0,3]})";
+        auto json = basic_json::parse(text, { .lazy_numbers = true }).value();
+
+        ASSERT_EQ(json.to_string(), text); // Byte for byte
+        ASSERT_EQ(json["price"].number_text(), "1.50");
+        ASSERT_TRUE(json["price"].is(basic_json::number));
+        ASSERT_EQ(json["price"].as<double>(), 1.5);
+        ASSERT_EQ(json["exp"].get<int>(), 100);
+        ASSERT_EQ(json["price"].to_string(), "1.50"); // Still the source text after converting
+        ASSERT_FALSE(json["list"].is_packed());
+        ASSERT_EQ(json["big"].as<double>(), 123456789012345678901234567890.0); // Too large for an integer
+        ASSERT_EQ(basic_json::parse("-9223372036854775808").value().as<std::int64_t>(), std::numeric_limits<std::int64_t>::min());
+
+        auto eager = basic_json::parse(text).value();
+        ASSERT_EQ(json, eager);
+        ASSERT_EQ(json.hash(), eager.hash());
+        ASSERT_FALSE(eager["price"].number_text().has_value());
+
+        basic_json copy = json;
+        copy["price"] = 2;
+        ASSERT_EQ(copy["price"].to_string(), "2");
+        ASSERT_EQ(json["price"].number_text(), "1.50");
+    }
+
+    TEST(BasicJsonTests, RawJson) {
+        std::string cached = R"({"items":[1,2,3],"name":"cached"})";
+        basic_json envelope{ { "status", "ok" }, { "data", basic_json::raw_json{ cached } } };
+
+        ASSERT_EQ(envelope.to_string(), R"({"status":"ok","data":{"items":[1,2,3],"name":"cached"}})");
+        ASSERT_EQ(envelope.serialized_size(), envelope.to_string().size());
+        ASSERT_EQ(envelope["data"].raw_text(), cached);
+
+        const basic_json& view = envelope;
+        ASSERT_EQ(view["data"]["name"], "cached"); // Parsed on first access
+        ASSERT_EQ(view["data"]["items"].size(), 3);
+        ASSERT_EQ(view["data"].raw_text(), cached); // Still written as is
+        ASSERT_EQ(envelope, basic_json::parse(envelope.to_string()).value());
+
+        basic_json copy = envelope;
+        copy["data"]["name"] = "changed"; // Mutable access replaces it with its value
+        ASSERT_FALSE(copy["data"].raw_text().has_value());
+        ASSERT_EQ(copy["data"].to_string(), R"({"items":[1,2,3],"name":"changed"})");
+        ASSERT_EQ(envelope["data"].raw_text(), cached);
+
+        basic_json spaced = basic_json::raw_json{ "[ 1, 2 ]" };
+        basic_json wrapped{ { "a", spaced } };
+        ASSERT_EQ(wrapped.to_pretty_string(), "{\n  \"a\": [ 1, 2 ]\n}");
+
+        // Escaped like any other text when the output must be ASCII
+        basic_json accented{ { "a", basic_json::raw_json{ "[\"caf\xC3\xA9 \xF0\x9F\x98\x80\"]" } } };
+        ASSERT_EQ(accented.to_ascii_string(), R"({"a":["caf\u00e9 \ud83d\ude00"]})");
+        ASSERT_EQ(accented.serialized_size({ .ascii_only = true }), accented.to_ascii_string().size());
+        ASSERT_EQ(accented.to_pretty_string({ .ascii_only = true }), "{\n  \"a\": [\"caf\\u00e9 \\ud83d\\ude00\"]\n}");
+    }
+
+    // ------------------------------------------------
+
     class ParseNumberTests : public ::testing::TestWithParam<std::tuple<std::string, double>> {};
 
     TEST_P(ParseNumberTests, ParseNumber) {
@@ -216,7 +1285,12 @@ namespace kaixo::test {
         std::make_tuple("-1.0E-2", -1E-2),
         std::make_tuple("-1.1E-2", -1.1E-2),
         std::make_tuple("-1.12345E-2", -1.12345E-2),
-        std::make_tuple("-12345.12345E-2", -12345.12345E-2)
+        std::make_tuple("-12345.12345E-2", -12345.12345E-2),
+        std::make_tuple("18446744073709551615", 18446744073709551615.0),
+        std::make_tuple("18446744073709551616", 18446744073709551616.0),
+        std::make_tuple("123456789012345678901234567890", 123456789012345678901234567890.0),
+        std::make_tuple("-9223372036854775808", -9223372036854775808.0),
+        std::make_tuple("-9223372036854775809", -9223372036854775809.0)
     ));
 
     // ------------------------------------------------